@@ -0,0 +1,158 @@
+#ifndef FAST_INPUT_H
+#define FAST_INPUT_H
+
+#include <stdio.h>
+#include <limits.h>
+
+/////Fast input
+//Shared reader of integers for the labs. Input is taken by big blocks and numbers are parsed by
+//hand, results are the same as of scanf: 1 when the number is read, 0 when something else is in the
+//input and EOF when only spaces are left. Too big numbers are saturated like strtoll does, "%d"
+//then cuts them to int, "%lli" also takes octal and hexadecimal numbers
+
+#define INPUT_BUFFER_SIZE (1 << 20)
+
+typedef struct _fast_input FastInput;
+
+struct _fast_input {
+    FILE* file;
+    const char* buffer;
+    size_t size;
+    size_t position;
+    char* block;
+};
+
+//Reads a file by blocks of INPUT_BUFFER_SIZE taken from the given storage
+static inline void openFileInput(FastInput* input, FILE* file, char* block) {
+    input -> file = file;
+    input -> buffer = block;
+    input -> size = 0;
+    input -> position = 0;
+    input -> block = block;
+}
+
+//Reads a text which is already in memory
+static inline void openMemoryInput(FastInput* input, const char* text, size_t size) {
+    input -> file = NULL;
+    input -> buffer = text;
+    input -> size = size;
+    input -> position = 0;
+    input -> block = NULL;
+}
+
+//Reader of stdin used by the labs instead of scanf
+static inline FastInput* standardInput() {
+    static char block[INPUT_BUFFER_SIZE];
+    static FastInput input;
+    if (!input.block) {
+        openFileInput(&input, stdin, block);
+    }
+
+    return &input;
+}
+
+static inline int peekInput(FastInput* input) {
+    if (input -> position == input -> size) {
+        if (!input -> file) {
+            return EOF;
+        }
+        input -> size = fread(input -> block, 1, INPUT_BUFFER_SIZE, input -> file);
+        input -> position = 0;
+        if (input -> size == 0) {
+            return EOF;
+        }
+    }
+
+    return (unsigned char)input -> buffer[input -> position];
+}
+
+static inline int isInputSpace(int c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+static inline int getDigitValue(int c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+
+    return 16;
+}
+
+//Base is 10 for "%d" and 0 for "%i", which takes it from the prefix of the number
+static inline int readNumber(FastInput* input, long long* value, int base) {
+    int c = peekInput(input);
+    while (isInputSpace(c)) {
+        input -> position++;
+        c = peekInput(input);
+    }
+    if (c == EOF) {
+        return EOF;
+    }
+
+    int isNegative = c == '-';
+    if (c == '-' || c == '+') {
+        input -> position++;
+        c = peekInput(input);
+    }
+
+    int isDigitFound = 0;
+    if (base == 0) {
+        base = 10;
+        if (c == '0') {
+            isDigitFound = 1;
+            input -> position++;
+            c = peekInput(input);
+            base = 8;
+            if (c == 'x' || c == 'X') {
+                input -> position++;
+                c = peekInput(input);
+                base = 16;
+            }
+        }
+    }
+
+    unsigned long long limit = isNegative ? (unsigned long long)LLONG_MAX + 1 : (unsigned long long)LLONG_MAX;
+    unsigned long long magnitude = 0;
+    int digit;
+    while ((digit = getDigitValue(c)) < base) {
+        if (magnitude > (limit - (unsigned long long)digit) / (unsigned long long)base) {
+            magnitude = limit;
+        } else {
+            magnitude = magnitude * (unsigned long long)base + (unsigned long long)digit;
+        }
+        isDigitFound = 1;
+        input -> position++;
+        c = peekInput(input);
+    }
+    if (!isDigitFound) {
+        return 0;
+    }
+
+    *value = isNegative ? (long long)(0 - magnitude) : (long long)magnitude;
+
+    return 1;
+}
+
+static inline int readInt(FastInput* input, int* value) {
+    long long number;
+    int result = readNumber(input, &number, 10);
+    if (result == 1) {
+        *value = (int)number;
+    }
+
+    return result;
+}
+
+static inline int readLongLong(FastInput* input, long long* value) {
+    return readNumber(input, value, 0);
+}
+
+//////////////////
+
+#endif
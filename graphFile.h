@@ -0,0 +1,255 @@
+#ifndef GRAPH_FILE_H
+#define GRAPH_FILE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "fastInput.h"
+
+/////Graph file
+//Binary form of the edge lists read by the graph labs. File is a header, then vertices + 1 offsets,
+//targets and weights of the edges (weights only in weighted graphs) and places of the edges in the
+//text. Edges of a vertex are the ones which had it first in the text, they keep the order of the text;
+//a program which needs the whole list in the order of the text puts every edge back to its place.
+//Vertices are counted from zero. All fields are 32-bit, so the program maps the file and takes the
+//arrays as they are
+
+#define GRAPH_FILE_MAGIC "CSRG"
+#define GRAPH_FILE_VERSION 2
+
+typedef enum {
+    GRAPH_FILE_SUCCESS,
+    GRAPH_FILE_NO_MEMORY,
+    GRAPH_FILE_BAD_INPUT,
+    GRAPH_FILE_BAD_VERTEX,
+    GRAPH_FILE_BAD_LENGTH,
+    GRAPH_FILE_CANNOT_WRITE,
+    GRAPH_FILE_CANNOT_OPEN,
+    GRAPH_FILE_BAD_FILE
+} GraphFileStatus;
+
+static const char* graphFileMessages[] = {
+        "success",
+        "no memory",
+        "bad number of lines",
+        "bad vertex",
+        "bad length",
+        "cannot write graph file",
+        "cannot open graph file",
+        "bad graph file"
+};
+
+typedef struct _graph_file_header GraphFileHeader;
+typedef struct _graph_file GraphFile;
+
+//Start and destination are kept for the labs which take them with the graph, otherwise they are zero
+struct _graph_file_header {
+    char magic[4];
+    int version;
+    int vertices;
+    int edges;
+    int isWeighted;
+    int start;
+    int destination;
+    int reserved;
+};
+
+struct _graph_file {
+    const GraphFileHeader* header;
+    const unsigned int* offsets;
+    const int* targets;
+    const int* weights;
+    const int* places;
+    void* mapping;
+    size_t size;
+};
+
+static inline size_t getGraphFileSize(int vertices, int edges, int isWeighted) {
+    return sizeof(GraphFileHeader) + ((size_t)vertices + 1) * sizeof(unsigned int) +
+            (size_t)edges * sizeof(int) * (isWeighted ? 3 : 2);
+}
+
+static inline GraphFileStatus writeGraphFile(const char* path, const GraphFileHeader* header,
+        const unsigned int* offsets, const int* targets, const int* weights, const int* places) {
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        return GRAPH_FILE_CANNOT_WRITE;
+    }
+
+    size_t edges = (size_t)header -> edges;
+    int isWritten = fwrite(header, sizeof(GraphFileHeader), 1, file) == 1 &&
+            fwrite(offsets, sizeof(unsigned int), (size_t)header -> vertices + 1, file) == (size_t)header -> vertices + 1 &&
+            fwrite(targets, sizeof(int), edges, file) == edges &&
+            (!header -> isWeighted || fwrite(weights, sizeof(int), edges, file) == edges) &&
+            fwrite(places, sizeof(int), edges, file) == edges;
+    if (fclose(file) != 0 || !isWritten) {
+        return GRAPH_FILE_CANNOT_WRITE;
+    }
+
+    return GRAPH_FILE_SUCCESS;
+}
+
+static inline void initGraphFileHeader(GraphFileHeader* header, int vertices, int edges, int isWeighted) {
+    memset(header, 0, sizeof(GraphFileHeader));
+    memcpy(header -> magic, GRAPH_FILE_MAGIC, sizeof(header -> magic));
+    header -> version = GRAPH_FILE_VERSION;
+    header -> vertices = vertices;
+    header -> edges = edges;
+    header -> isWeighted = isWeighted;
+}
+
+//The program reads and checks the numbers before the edges by itself, so they fail as in the text
+//run and nothing is allocated for counts it doesn't take. Then header -> edges lines "first second"
+//or "first second length" are read here, vertices have to be in 1..vertices and lengths in 0..INT_MAX
+static inline GraphFileStatus convertGraphText(FastInput* input, const char* path, const GraphFileHeader* header) {
+    size_t edges = (size_t)header -> edges;
+    size_t allocated = edges > 0 ? edges : 1;
+    int isWeighted = header -> isWeighted;
+    int* sources = (int*)malloc(allocated * sizeof(int));
+    int* textTargets = (int*)malloc(allocated * sizeof(int));
+    int* textWeights = isWeighted ? (int*)malloc(allocated * sizeof(int)) : NULL;
+    unsigned int* offsets = (unsigned int*)calloc((size_t)header -> vertices + 1, sizeof(unsigned int));
+    int* targets = (int*)malloc(allocated * sizeof(int));
+    int* weights = isWeighted ? (int*)malloc(allocated * sizeof(int)) : NULL;
+    int* places = (int*)malloc(allocated * sizeof(int));
+    GraphFileStatus status = sources && textTargets && offsets && targets && places &&
+            (!isWeighted || (textWeights && weights)) ?
+            GRAPH_FILE_SUCCESS : GRAPH_FILE_NO_MEMORY;
+
+    for (size_t i = 0; i < edges && status == GRAPH_FILE_SUCCESS; i++) {
+        int first, second;
+        long long length = 0;
+        if (readInt(input, &first) != 1 || readInt(input, &second) != 1 ||
+                (isWeighted && readLongLong(input, &length) != 1)) {
+            status = GRAPH_FILE_BAD_INPUT;
+        } else if (first < 1 || second < 1 || first > header -> vertices || second > header -> vertices) {
+            status = GRAPH_FILE_BAD_VERTEX;
+        } else if (length < 0 || length > INT_MAX) {
+            status = GRAPH_FILE_BAD_LENGTH;
+        } else {
+            sources[i] = first - 1;
+            textTargets[i] = second - 1;
+            if (isWeighted) {
+                textWeights[i] = (int)length;
+            }
+            offsets[first]++;
+        }
+    }
+
+    //Counting sort by the first vertex keeps the order of the text inside a vertex
+    if (status == GRAPH_FILE_SUCCESS) {
+        for (int v = 0; v < header -> vertices; v++) {
+            offsets[v + 1] += offsets[v];
+        }
+        for (size_t i = 0; i < edges; i++) {
+            unsigned int place = offsets[sources[i]]++;
+            targets[place] = textTargets[i];
+            places[place] = (int)i;
+            if (isWeighted) {
+                weights[place] = textWeights[i];
+            }
+        }
+        for (int v = header -> vertices; v > 0; v--) {
+            offsets[v] = offsets[v - 1];
+        }
+        offsets[0] = 0;
+        status = writeGraphFile(path, header, offsets, targets, weights, places);
+    }
+
+    free(sources);
+    free(textTargets);
+    free(textWeights);
+    free(offsets);
+    free(targets);
+    free(weights);
+    free(places);
+
+    return status;
+}
+
+static inline void closeGraphFile(GraphFile* graphFile) {
+    if (graphFile -> mapping) {
+        munmap(graphFile -> mapping, graphFile -> size);
+    }
+    memset(graphFile, 0, sizeof(GraphFile));
+}
+
+//File is checked as a whole before use: it has weights when the program needs them and only then,
+//sizes agree with the header, offsets grow up to the number of edges, targets are vertices and
+//weights are not negative
+static inline GraphFileStatus openGraphFile(GraphFile* graphFile, const char* path, int isWeighted) {
+    memset(graphFile, 0, sizeof(GraphFile));
+    int descriptor = open(path, O_RDONLY);
+    if (descriptor < 0) {
+        return GRAPH_FILE_CANNOT_OPEN;
+    }
+
+    struct stat fileStat;
+    int isStatRead = fstat(descriptor, &fileStat) == 0;
+    if (!isStatRead || (size_t)fileStat.st_size < sizeof(GraphFileHeader)) {
+        close(descriptor);
+        return isStatRead ? GRAPH_FILE_BAD_FILE : GRAPH_FILE_CANNOT_OPEN;
+    }
+    graphFile -> size = (size_t)fileStat.st_size;
+    void* mapping = mmap(NULL, graphFile -> size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    close(descriptor);
+    if (mapping == MAP_FAILED) {
+        graphFile -> size = 0;
+        return GRAPH_FILE_CANNOT_OPEN;
+    }
+    graphFile -> mapping = mapping;
+
+    const GraphFileHeader* header = (const GraphFileHeader*)mapping;
+    if (memcmp(header -> magic, GRAPH_FILE_MAGIC, sizeof(header -> magic)) != 0 ||
+            header -> version != GRAPH_FILE_VERSION || header -> isWeighted != isWeighted ||
+            header -> vertices < 0 || header -> edges < 0 ||
+            getGraphFileSize(header -> vertices, header -> edges, isWeighted) != graphFile -> size) {
+        closeGraphFile(graphFile);
+        return GRAPH_FILE_BAD_FILE;
+    }
+    graphFile -> header = header;
+    graphFile -> offsets = (const unsigned int*)(header + 1);
+    graphFile -> targets = (const int*)(graphFile -> offsets + header -> vertices + 1);
+    graphFile -> weights = header -> isWeighted ? graphFile -> targets + header -> edges : NULL;
+    graphFile -> places = graphFile -> targets + (size_t)header -> edges * (header -> isWeighted ? 2 : 1);
+
+    int isValid = graphFile -> offsets[0] == 0 && graphFile -> offsets[header -> vertices] == (unsigned int)header -> edges;
+    for (int v = 0; v < header -> vertices && isValid; v++) {
+        isValid = graphFile -> offsets[v] <= graphFile -> offsets[v + 1];
+    }
+    for (int i = 0; i < header -> edges && isValid; i++) {
+        isValid = graphFile -> targets[i] >= 0 && graphFile -> targets[i] < header -> vertices &&
+                (!graphFile -> weights || graphFile -> weights[i] >= 0);
+    }
+
+    //Places have to be every edge once, so that no edge of the list is lost or repeated
+    unsigned char* isPlaced = isValid ? (unsigned char*)calloc((size_t)header -> edges + 1, 1) : NULL;
+    if (isValid && !isPlaced) {
+        closeGraphFile(graphFile);
+        return GRAPH_FILE_NO_MEMORY;
+    }
+    for (int i = 0; i < header -> edges && isValid; i++) {
+        int place = graphFile -> places[i];
+        isValid = place >= 0 && place < header -> edges && !isPlaced[place];
+        if (isValid) {
+            isPlaced[place] = 1;
+        }
+    }
+    free(isPlaced);
+    if (!isValid) {
+        closeGraphFile(graphFile);
+        return GRAPH_FILE_BAD_FILE;
+    }
+
+    return GRAPH_FILE_SUCCESS;
+}
+
+//////////////////
+
+#endif
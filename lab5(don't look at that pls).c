@@ -2,62 +2,170 @@
 #include <mm_malloc.h>
 #include <memory.h>
 #include <assert.h>
+#include <time.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAS_X86_KERNELS
+#endif
 
 #define false 0
 #define true 1
 
 #define NUMBER_OF_CHARS 256
-
-FILE* fileIn;
-FILE* fileOut;
+#define MAX_CODE_LENGTH 63
+#define LENGTH_BITS 6
+
+//Encoder never makes codes longer than CODE_LENGTH_LIMIT, so decoding needs at most two table
+//lookups per symbol. Limit can't be less than 8: 256 symbols must fit
+#define CODE_LENGTH_LIMIT 15
+#define MAX_CODE_LENGTH_LIMIT 32
+
+//Last byte of the signature is the version with the highest bit set,
+//so the signature never looks like a count of the old format. All sizes are 64-bit varints;
+//versions 4 and 5 are 2 and 3 with a checksum of every block, versions 6 and 7 are 4 and 5
+//where every block starts with its mode. Only 6 and 7 are written now
+#define SIGNATURE_SIZE 4
+#define SINGLE_BLOCK_VERSION 1
+#define BLOCKS_VERSION 2
+#define STREAM_VERSION 3
+#define CHECKED_BLOCKS_VERSION 4
+#define CHECKED_STREAM_VERSION 5
+#define MODAL_BLOCKS_VERSION 6
+#define MODAL_STREAM_VERSION 7
+const unsigned char SIGNATURE[SIGNATURE_SIZE - 1] = {'H', 'U', 'F'};
 
 typedef enum {
     SUCCESS,
     OUT_OF_MEMORY,
     WRONG_INPUT,
-    FILE_ERROR
+    FILE_ERROR,
+    BUFFER_TOO_SMALL,
+    CHECKSUM_MISMATCH,
+    BENCHMARK_REGRESSION
 } ExitCodes;
 
 const char* exitMessages[] = {
         "success",
         "out of memory",
         "wrong input",
-        "file error"
+        "file error",
+        "output buffer is too small",
+        "checksum mismatch",
+        "benchmark regression"
 };
 
-ExitCodes encoding();
-ExitCodes decoding();
-
-const char* ZERO = "0";
-const char* ONE = "1";
-
 /////Declare structures
 
 typedef struct _node Node;
+typedef struct _byte_source ByteSource;
 typedef struct _input_stream InputStream;
 typedef struct _output_stream OutputStream;
+typedef struct _code_lengths CodeLengths;
+typedef struct _thread_pool ThreadPool;
+typedef struct _arena Arena;
+typedef struct _tree_memory TreeMemory;
+typedef struct _encoder_options EncoderOptions;
 
 ///////////////////////
 
-/////Starting methods
-void getMessage(ExitCodes exitCode) {
-    fprintf(fileOut,"%s", exitMessages[exitCode]);
+/////Arena
+//Everything one block needs while it is coded (tree nodes, decode tables) is taken from big chunks
+//and given back at once. Reset keeps the chunks, so the next block of the same job doesn't touch
+//the heap at all
+
+#define ARENA_CHUNK_SIZE (1 << 16)
+#define ARENA_ALIGNMENT 16
+
+typedef struct _arena_chunk ArenaChunk;
+
+struct _arena_chunk {
+    ArenaChunk* next;
+    size_t size;
+    size_t used;
+};
+
+struct _arena {
+    ArenaChunk* chunks;
+    ArenaChunk* current;
+};
+
+size_t alignArenaSize(size_t size) {
+    return (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
 }
 
-int correctOption(unsigned char* option) {
-    if (fread(option, sizeof(unsigned char), 2, fileIn) < 2 || option[1] != '\n') {
-        return false;
+unsigned char* getChunkData(ArenaChunk* chunk) {
+    return (unsigned char*)chunk + alignArenaSize(sizeof(ArenaChunk));
+}
+
+//Memory is zeroed like the one from calloc()
+void* arenaAlloc(Arena* arena, size_t size) {
+    size = alignArenaSize(size ? size : 1);
+
+    //Chunks after the current one are left from the previous use
+    ArenaChunk* chunk = arena -> current;
+    while (chunk && chunk -> size - chunk -> used < size) {
+        chunk = chunk -> next;
+        if (chunk) {
+            chunk -> used = 0;
+        }
     }
 
-    return true;
+    if (!chunk) {
+        size_t chunkSize = size > ARENA_CHUNK_SIZE ? size : ARENA_CHUNK_SIZE;
+        chunk = (ArenaChunk*)malloc(alignArenaSize(sizeof(ArenaChunk)) + chunkSize);
+        if (!chunk) {
+            return NULL;
+        }
+
+        chunk -> size = chunkSize;
+        chunk -> used = 0;
+        if (arena -> current) {
+            chunk -> next = arena -> current -> next;
+            arena -> current -> next = chunk;
+        } else {
+            chunk -> next = arena -> chunks;
+            arena -> chunks = chunk;
+        }
+    }
+    arena -> current = chunk;
+
+    void* memory = getChunkData(chunk) + chunk -> used;
+    chunk -> used += size;
+    memset(memory, 0, size);
+
+    return memory;
 }
 
-/////////////////////
+void resetArena(Arena* arena) {
+    arena -> current = arena -> chunks;
+    if (arena -> current) {
+        arena -> current -> used = 0;
+    }
+}
+
+void freeArena(Arena* arena) {
+    while (arena -> chunks) {
+        ArenaChunk* next = arena -> chunks -> next;
+        free(arena -> chunks);
+        arena -> chunks = next;
+    }
+
+    arena -> current = NULL;
+}
+
+///////////////////
 
 /////Definition of struct Node
 
 struct _node {
-    int freq;
+    unsigned long long freq;
     unsigned char symbol;
     Node* left;
     Node* right;
@@ -67,487 +175,2954 @@ int isLeaf(Node* curNode) {
     return !curNode -> left && !curNode -> right;
 }
 
-Node** initNodePointerArray() {
-    Node** newArray = (Node**)calloc(NUMBER_OF_CHARS + 1, sizeof(Node*));
-    if (!newArray) {
-        return NULL;
-    }
+//Leaves of all symbols and place for merged nodes are taken once per block, every tree of the
+//block is built in them again
+struct _tree_memory {
+    Node** arrayOfNodes;
+    Node* leaves;
+    Node* mergedNodes;
+};
 
-    for (int i = 0; i < NUMBER_OF_CHARS; i++) {
-        newArray[i] = (Node*)calloc(1, sizeof(Node));
-        if (!newArray[i]) {
-            for (int j = i - 1; j >= 0; j--) {
-                free(newArray[j]);
-            }
+int allocTreeMemory(TreeMemory* memory, Arena* arena) {
+    memory -> arrayOfNodes = (Node**)arenaAlloc(arena, (NUMBER_OF_CHARS + 1) * sizeof(Node*));
+    memory -> leaves = (Node*)arenaAlloc(arena, NUMBER_OF_CHARS * sizeof(Node));
+    memory -> mergedNodes = (Node*)arenaAlloc(arena, (NUMBER_OF_CHARS - 1) * sizeof(Node));
 
-            free(newArray);
-            return NULL;
-        }
+    return memory -> arrayOfNodes && memory -> leaves && memory -> mergedNodes;
+}
 
-        newArray[i] -> symbol = (unsigned char)i;
+void initNodePointerArray(TreeMemory* memory, const unsigned long long* frequencies) {
+    for (int i = 0; i < NUMBER_OF_CHARS; i++) {
+        memory -> leaves[i] = (Node){frequencies[i], (unsigned char)i, NULL, NULL};
+        memory -> arrayOfNodes[i] = &memory -> leaves[i];
     }
-
-    return newArray;
 }
 
 //////////////////////////////
 
-/////Definition of input stream
+/////Definition of byte source
+//Input is either mapped into memory as a whole (regular files), read by big blocks (pipes) or
+//given as memory already; readers take it chunk by chunk without per-byte calls
 
-struct _input_stream {
-    unsigned char* buffer;
-    unsigned char current;
-    int curIndex;
-    int capacity;
+#define INPUT_BUFFER_SIZE (1 << 20)
+
+typedef enum {
+    STREAM_SOURCE,
+    MAPPED_SOURCE,
+    MEMORY_SOURCE
+} SourceKind;
+
+struct _byte_source {
+    FILE* file;
+    unsigned char* data;
+    size_t size;
+    size_t position;
+    SourceKind kind;
+    int ownsData;
 };
 
-InputStream* allocInputStream() {
-    InputStream* newInputStream = (InputStream*)calloc(1, sizeof(InputStream));
-    if (!newInputStream) {
+ByteSource* openByteSource(FILE* file) {
+    ByteSource* source = (ByteSource*)calloc(1, sizeof(ByteSource));
+    if (!source) {
         return NULL;
     }
-    newInputStream -> buffer = (unsigned char*)calloc(9, sizeof(unsigned char));
-    if (!newInputStream -> buffer) {
-        free(newInputStream);
+    source -> file = file;
+
+    struct stat fileInfo;
+    long offset = ftell(file);
+    if (offset >= 0 && fstat(fileno(file), &fileInfo) == 0 && S_ISREG(fileInfo.st_mode) &&
+            fileInfo.st_size > offset) {
+        void* mapped = mmap(NULL, (size_t)fileInfo.st_size, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+        if (mapped != MAP_FAILED) {
+            madvise(mapped, (size_t)fileInfo.st_size, MADV_SEQUENTIAL);
+            source -> data = (unsigned char*)mapped;
+            source -> size = (size_t)fileInfo.st_size;
+            source -> position = (size_t)offset;
+            source -> kind = MAPPED_SOURCE;
+
+            return source;
+        }
+    }
+
+    source -> data = (unsigned char*)malloc(INPUT_BUFFER_SIZE);
+    if (!source -> data) {
+        free(source);
         return NULL;
     }
+    source -> kind = STREAM_SOURCE;
+    source -> ownsData = true;
 
-    return newInputStream;
+    return source;
 }
 
-int readSingleSymbol(InputStream* input) {
-    return fread(&input -> current, sizeof(unsigned char), 1, fileIn) == 1;
+//Source over memory of someone else, nothing has to be closed
+void initMemorySource(ByteSource* source, const unsigned char* data, size_t size) {
+    *source = (ByteSource){NULL, (unsigned char*)data, size, 0, MEMORY_SOURCE, false};
 }
 
-int isNewSymbol(InputStream* input) {
-    assert(input -> buffer);
+void closeByteSource(ByteSource* source) {
+    if (source -> kind == MAPPED_SOURCE) {
+        munmap(source -> data, source -> size);
+    } else if (source -> ownsData) {
+        free(source -> data);
+    }
 
-    return input -> curIndex == 0;
+    free(source);
 }
 
-unsigned char getCurBit(InputStream* input) {
-    assert(input -> buffer);
+//Makes sure there is at least one unread byte in the window
+int fillByteSource(ByteSource* source) {
+    if (source -> position < source -> size) {
+        return true;
+    }
+    if (source -> kind != STREAM_SOURCE) {
+        return false;
+    }
+
+    source -> size = fread(source -> data, sizeof(unsigned char), INPUT_BUFFER_SIZE, source -> file);
+    source -> position = 0;
 
-    return input -> buffer[input -> curIndex];
+    return source -> size > 0;
 }
 
-///////////////////////////////
+//Reads the rest of a stream into memory, after that all unread bytes are in one window
+int loadWholeSource(ByteSource* source) {
+    if (source -> kind != STREAM_SOURCE) {
+        return true;
+    }
 
-/////Definition of output stream
+    size_t size = source -> size - source -> position;
+    size_t capacity = size > INPUT_BUFFER_SIZE ? size : INPUT_BUFFER_SIZE;
+    unsigned char* data = (unsigned char*)malloc(capacity);
+    if (!data) {
+        return false;
+    }
+    memcpy(data, source -> data + source -> position, size);
+
+    size_t part;
+    do {
+        if (size == capacity) {
+            unsigned char* newData = (unsigned char*)realloc(data, 2 * capacity);
+            if (!newData) {
+                free(data);
+                return false;
+            }
 
-struct _output_stream {
-    unsigned char* buffer;
-    int curSize;
-    int capacity;
-};
+            data = newData;
+            capacity *= 2;
+        }
 
-OutputStream* allocOutputStream() {
-    OutputStream* outputStream = (OutputStream*)calloc(1, sizeof(OutputStream));
-    if (!outputStream) {
-        return NULL;
-    }
-    outputStream -> buffer = (unsigned char*)calloc(2 * NUMBER_OF_CHARS + 2, sizeof(unsigned char));
-    if (!outputStream -> buffer) {
-        free(outputStream);
-        return NULL;
-    }
+        part = fread(data + size, sizeof(unsigned char), capacity - size, source -> file);
+        size += part;
+    } while (part > 0);
 
-    return outputStream;
+    free(source -> data);
+    source -> data = data;
+    source -> size = size;
+    source -> position = 0;
+    source -> kind = MEMORY_SOURCE;
+
+    return true;
 }
 
-void writeByte(OutputStream* outputStream) {
-    int toWrite = 0;
-    for (int i = 0; i < 8; i++) {
-        toWrite = 2 * toWrite + (outputStream -> buffer[i] - '0');
+//Gives all bytes that are available without waiting for the next block
+int nextChunk(ByteSource* source, const unsigned char** chunk, size_t* length) {
+    if (!fillByteSource(source)) {
+        return false;
     }
 
-    unsigned char result = (unsigned char)toWrite;
-    fwrite(&result, sizeof(unsigned char), 1, fileOut);
+    *chunk = source -> data + source -> position;
+    *length = source -> size - source -> position;
+    source -> position = source -> size;
 
-    memmove(outputStream -> buffer, outputStream -> buffer + 8, outputStream -> curSize - 8);
-    outputStream -> curSize -= 8;
-    if (outputStream -> curSize >= 8) {
-        writeByte(outputStream);
-    }
+    return true;
 }
 
-void append(OutputStream* outputStream, const unsigned char* string) {
-    for (int i = 0; i < (int)strlen((const char*)string); i++) {
-        outputStream -> buffer[outputStream -> curSize++] = string[i];
+size_t readBytes(ByteSource* source, unsigned char* destination, size_t count) {
+    size_t done = 0;
+    while (done < count && fillByteSource(source)) {
+        size_t part = source -> size - source -> position;
+        if (part > count - done) {
+            part = count - done;
+        }
+
+        memcpy(destination + done, source -> data + source -> position, part);
+        source -> position += part;
+        done += part;
     }
 
+    return done;
+}
+
+//Gives bytes in place when the source is in memory, otherwise copies them to the buffer
+size_t takeBytes(ByteSource* source, size_t count, unsigned char* buffer, const unsigned char** data) {
+    if (source -> kind == STREAM_SOURCE) {
+        *data = buffer;
+        return readBytes(source, buffer, count);
+    }
 
-    if (outputStream -> curSize >= 8) {
-        writeByte(outputStream);
+    size_t available = source -> size - source -> position;
+    if (count > available) {
+        count = available;
     }
+    *data = source -> data + source -> position;
+    source -> position += count;
+
+    return count;
 }
 
-void writePadding(OutputStream* outputStream) {
-    for (int i = outputStream -> curSize; i < 8; i++) {
-        outputStream -> buffer[i] = '0';
+int readNumber(ByteSource* source, unsigned long long* number) {
+    *number = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        unsigned char part;
+        if (readBytes(source, &part, 1) < 1) {
+            return false;
+        }
+
+        *number |= (unsigned long long)(part & 0x7F) << shift;
+        if (!(part & 0x80)) {
+            return true;
+        }
     }
 
-    outputStream -> curSize = 8;
-    writeByte(outputStream);
+    return false;
 }
 
-////////////////////////////////
+/////////////////////////////
 
+/////Definition of input stream
 
-/////Encoding
+struct _input_stream {
+    ByteSource* source;
+    unsigned long long bitBuffer;
+    int bitCount;
+};
 
-int compareNodes(const void** a, const void** b) {
-    const Node** first = (const Node**)a;
-    const Node** second = (const Node**)b;
+InputStream* allocInputStream(ByteSource* source) {
+    InputStream* newInputStream = (InputStream*)calloc(1, sizeof(InputStream));
+    if (!newInputStream) {
+        return NULL;
+    }
+    newInputStream -> source = source;
 
-    return (*first) -> freq - (*second) -> freq;
+    return newInputStream;
 }
 
-int power(int base, int degree) {
-    int answer = 1;
-    for (int i = 1; i <= degree; i++) {
-        answer *= base;
+//Bits are kept aligned to the top of bitBuffer, so the next bit to read is always bit 63
+void refillBits(InputStream* input) {
+    ByteSource* source = input -> source;
+    while (input -> bitCount <= 56 && fillByteSource(source)) {
+        input -> bitBuffer |= (unsigned long long)source -> data[source -> position++] << (56 - input -> bitCount);
+        input -> bitCount += 8;
     }
+}
 
-    return answer;
+unsigned int peekBits(InputStream* input, int count) {
+    return (unsigned int)(input -> bitBuffer >> (64 - count));
 }
 
-int readInput(Node** arr, int* total) {
-    InputStream* firstReading = (InputStream*)calloc(1, sizeof(InputStream));
-    if (!firstReading) {
-        return false;
-    }
+void skipBits(InputStream* input, int count) {
+    input -> bitBuffer <<= count;
+    input -> bitCount -= count;
+}
 
-    while (readSingleSymbol(firstReading)) {
-        if (firstReading -> current != '\n') {
-            arr[firstReading->current] -> freq++;
-            (*total)++;
+int readBits(InputStream* input, int count, unsigned int* result) {
+    if (input -> bitCount < count) {
+        refillBits(input);
+        if (input -> bitCount < count) {
+            return false;
         }
     }
 
-    fseek(fileIn, 2, SEEK_SET);
-    free(firstReading);
+    *result = peekBits(input, count);
+    skipBits(input, count);
+
     return true;
 }
 
-int insertNewNode(Node** arr, int indexOfFirst) {
-    Node* newNode = (Node*)calloc(1, sizeof(Node));
-    if (!newNode) {
-        return false;
-    }
-    newNode -> left = (Node*)calloc(1, sizeof(Node));
-    newNode -> right = (Node*)calloc(1, sizeof(Node));
-    if (!newNode -> left || !newNode -> right) {
-        return false;
-    }
+void alignToByte(InputStream* input) {
+    skipBits(input, input -> bitCount % 8);
+}
 
-    memcpy(newNode -> left, arr[indexOfFirst], sizeof(Node));
-    memcpy(newNode -> right, arr[indexOfFirst + 1], sizeof(Node));
-    newNode -> freq = newNode -> left -> freq + newNode -> right -> freq;
-    memcpy(arr[indexOfFirst + 1], newNode, sizeof(Node));
+//Gives the rest of the source in place, bytes which are already in bitBuffer are put back first.
+//Stream has to be aligned and read from memory, nothing is left in it after that
+void takeRemainingBytes(InputStream* input, const unsigned char** data, size_t* size) {
+    ByteSource* source = input -> source;
+    assert(source -> kind != STREAM_SOURCE && input -> bitCount % 8 == 0);
 
-    return true;
-}
+    source -> position -= (size_t)(input -> bitCount / 8);
+    *data = source -> data + source -> position;
+    *size = source -> size - source -> position;
+    source -> position = source -> size;
 
-int buildTree(Node** arr, Node* tree) {
-    int indexOfBeginning = -1;
+    input -> bitBuffer = 0;
+    input -> bitCount = 0;
+}
 
-    qsort(arr, NUMBER_OF_CHARS, sizeof(Node*), (__compar_fn_t)compareNodes);
+///////////////////////////////
 
-    for (int i = 0; i < NUMBER_OF_CHARS; i++) {
-        if (arr[i] -> freq > 0) {
-            indexOfBeginning = i;
-            break;
-        }
-    }
+/////Definition of output stream
+//Bits are packed into bitBuffer (the newest one is the lowest) and moved to the byte buffer by 32.
+//The byte buffer goes to the file only when it is full; stream without file keeps everything in
+//memory and grows instead, unless the buffer is given by the caller. Writes to a broken stream
+//are dropped
 
-    for (int i = indexOfBeginning; i < NUMBER_OF_CHARS - 1; i++) {
-        if (!insertNewNode(arr, i)) {
-            return false;
-        }
+#define OUTPUT_BUFFER_SIZE (1 << 16)
 
-        int curLength = NUMBER_OF_CHARS - i - 1;
-        qsort(arr + i + 1, curLength, sizeof(Node*), (__compar_fn_t)compareNodes);
-    }
+typedef struct _code Code;
 
-    memcpy(tree, arr[NUMBER_OF_CHARS - 1], sizeof(Node));
+struct _code {
+    unsigned long long bits;
+    int length;
+};
 
-    return true;
-}
+struct _output_stream {
+    FILE* file;
+    unsigned long long bitBuffer;
+    int bitCount;
+    unsigned char* buffer;
+    size_t curSize;
+    size_t capacity;
+    int isBroken;
+    int ownsBuffer;
+};
 
-unsigned char* getInBitArray(unsigned char symbol) {
-    unsigned char* result = (unsigned char*)calloc(9, sizeof(unsigned char));
-    if (!result) {
+OutputStream* allocOutputStream(FILE* file, size_t capacity) {
+    OutputStream* outputStream = (OutputStream*)calloc(1, sizeof(OutputStream));
+    if (!outputStream) {
         return NULL;
     }
-
-    for (int i = 7; i >= 0; i--) {
-        result[7 - i] = ((symbol >> i) % 2) + '0';
+    if (capacity < 4) {
+        capacity = 4;
+    }
+    outputStream -> buffer = (unsigned char*)malloc(capacity);
+    if (!outputStream -> buffer) {
+        free(outputStream);
+        return NULL;
     }
+    outputStream -> file = file;
+    outputStream -> capacity = capacity;
+    outputStream -> ownsBuffer = true;
 
-    return result;
+    return outputStream;
 }
 
-void writeTree(Node* curNode, OutputStream* outputStream) {
-    if (isLeaf(curNode)) {
-        append(outputStream, (unsigned char*)ONE);
-        unsigned char* symbolInBitArray = getInBitArray(curNode -> symbol);
-        append(outputStream, symbolInBitArray);
-
-        return;
-    }
+//Stream over memory of the caller, it never grows
+void initBufferOutputStream(OutputStream* outputStream, unsigned char* buffer, size_t capacity) {
+    *outputStream = (OutputStream){NULL, 0, 0, buffer, 0, capacity, false, false};
+}
 
-    append(outputStream, (unsigned char*)ZERO);
-    writeTree(curNode -> left, outputStream);
-    writeTree(curNode -> right, outputStream);
+//Memory stream may be used again for the next block
+void resetOutputStream(OutputStream* outputStream) {
+    outputStream -> bitBuffer = 0;
+    outputStream -> bitCount = 0;
+    outputStream -> curSize = 0;
+    outputStream -> isBroken = false;
 }
 
-int writingData(int count, Node* tree) {
-    fwrite(&count, sizeof(int), 1, fileOut);
+void freeOutputStream(OutputStream* outputStream) {
+    if (outputStream -> ownsBuffer) {
+        free(outputStream -> buffer);
+    }
+    free(outputStream);
+}
 
-    OutputStream* outputStream = allocOutputStream();
-    if (!outputStream) {
+//Makes room in the buffer. Stream is marked as broken if it can't be done
+int flushOutputStream(OutputStream* outputStream) {
+    if (outputStream -> isBroken) {
         return false;
     }
-    writeTree(tree, outputStream);
-    writePadding(outputStream);
 
-    return true;
-}
-
-void startFilling(unsigned char** table, Node* curNode, int number, int curLevel) {
-    if (isLeaf(curNode)) {
-        for (int i = 0; i < curLevel; i++) {
-            switch ((number >> i) % 2) {
-                case 0:
-                    table[curNode -> symbol][i] = '0';
-                    break;
-                case 1:
-                    table[curNode -> symbol][i] = '1';
-                    break;
-                default:
-                    break;
-            }
+    if (!outputStream -> file) {
+        unsigned char* newBuffer = NULL;
+        if (outputStream -> ownsBuffer) {
+            newBuffer = (unsigned char*)realloc(outputStream -> buffer, 2 * outputStream -> capacity);
+        }
+        if (!newBuffer) {
+            outputStream -> isBroken = true;
+            return false;
         }
 
-        return;
+        outputStream -> buffer = newBuffer;
+        outputStream -> capacity *= 2;
+        return true;
+    }
+
+    size_t toWrite = outputStream -> curSize;
+    outputStream -> curSize = 0;
+    if (fwrite(outputStream -> buffer, sizeof(unsigned char), toWrite, outputStream -> file) != toWrite) {
+        outputStream -> isBroken = true;
     }
 
-    startFilling(table, curNode -> left, number, curLevel + 1);
-    startFilling(table, curNode -> right, number + power(2, curLevel), curLevel + 1);
+    return !outputStream -> isBroken;
 }
 
-unsigned char** initCodesTable(Node* tree) {
-    unsigned char** newTable = (unsigned char**)calloc(NUMBER_OF_CHARS + 1, sizeof(unsigned char*));
-    if (!newTable) {
-        return NULL;
-    }
-    for (int i = 0; i < NUMBER_OF_CHARS; i++) {
-        newTable[i] = (unsigned char*)calloc(NUMBER_OF_CHARS + 1, sizeof(unsigned char));
-        if (!newTable[i]) {
-            for (int j = i - 1; j >= 0; j--) {
-                free(newTable[j]);
-            }
+//Hands written bytes to the file, memory stream just keeps them
+int emitOutputStream(OutputStream* outputStream) {
+    return outputStream -> file ? flushOutputStream(outputStream) : !outputStream -> isBroken;
+}
 
-            free(newTable);
-            return NULL;
-        }
+ExitCodes getOutputError(const OutputStream* outputStream) {
+    if (outputStream -> file) {
+        return FILE_ERROR;
     }
 
-    startFilling(newTable, tree, 0, 0);
-
-    return newTable;
+    return outputStream -> ownsBuffer ? OUT_OF_MEMORY : BUFFER_TOO_SMALL;
 }
 
-int transformingAndZip(unsigned char** codes) {
-    InputStream* secondRead = (InputStream*)calloc(1, sizeof(InputStream));
-    if (!secondRead) {
-        return false;
-    }
-    OutputStream* outputStream = allocOutputStream();
-    if (!outputStream) {
-        return false;
+//Moves everything from memory stream source to destination
+int appendOutputStream(OutputStream* destination, const OutputStream* source) {
+    assert(destination -> bitCount == 0 && source -> bitCount == 0);
+
+    if (destination -> file) {
+        if (!flushOutputStream(destination)) {
+            return false;
+        }
+        if (fwrite(source -> buffer, sizeof(unsigned char), source -> curSize, destination -> file) !=
+                source -> curSize) {
+            destination -> isBroken = true;
+        }
+
+        return !destination -> isBroken;
     }
 
-    while (readSingleSymbol(secondRead)) {
-        append(outputStream, codes[secondRead -> current]);
+    while (destination -> capacity - destination -> curSize < source -> curSize) {
+        if (!flushOutputStream(destination)) {
+            return false;
+        }
     }
-    writePadding(outputStream);
+    memcpy(destination -> buffer + destination -> curSize, source -> buffer, source -> curSize);
+    destination -> curSize += source -> curSize;
 
     return true;
 }
 
-/////////////
-
-ExitCodes encoding() {
-    //First of all we have to build tree
-    Node** arrayOfNodes = initNodePointerArray();
-    if (!arrayOfNodes) {
-        return OUT_OF_MEMORY;
+void writeBits(OutputStream* outputStream, unsigned long long bits, int length) {
+    if (length > 32) {
+        writeBits(outputStream, bits >> 32, length - 32);
+        bits &= 0xFFFFFFFFULL;
+        length = 32;
     }
 
-    int totalRead = 0;
-    if (!readInput(arrayOfNodes, &totalRead)) {
-        return OUT_OF_MEMORY;
-    }
-    if (totalRead == 0) {
-        return SUCCESS;
+    outputStream -> bitBuffer = (outputStream -> bitBuffer << length) | bits;
+    outputStream -> bitCount += length;
+    if (outputStream -> bitCount < 32) {
+        return;
     }
 
-    Node* huffmanTree = (Node*)calloc(1, sizeof(Node));
-    if (!huffmanTree) {
-        return OUT_OF_MEMORY;
-    }
-    if (!buildTree(arrayOfNodes, huffmanTree)) {
-        return OUT_OF_MEMORY;
+    outputStream -> bitCount -= 32;
+    if (outputStream -> curSize + 4 > outputStream -> capacity && !flushOutputStream(outputStream)) {
+        return;
     }
 
-    //Writing data for decoding
-    if (!writingData(totalRead, huffmanTree)) {
-        return OUT_OF_MEMORY;
+    unsigned int word = (unsigned int)(outputStream -> bitBuffer >> outputStream -> bitCount);
+    unsigned char* place = outputStream -> buffer + outputStream -> curSize;
+    place[0] = (unsigned char)(word >> 24);
+    place[1] = (unsigned char)(word >> 16);
+    place[2] = (unsigned char)(word >> 8);
+    place[3] = (unsigned char)word;
+    outputStream -> curSize += 4;
+}
+
+void writePadding(OutputStream* outputStream) {
+    int rest = (8 - outputStream -> bitCount % 8) % 8;
+    if (rest) {
+        writeBits(outputStream, 0, rest);
     }
 
-    //Secondly we should get table of codes to encode symbols for O(1)
-    unsigned char** codesTable = initCodesTable(huffmanTree);
-    if (!codesTable) {
-        return OUT_OF_MEMORY;
+    //Less than 32 bits are left, all of them are whole bytes now
+    while (outputStream -> bitCount > 0) {
+        outputStream -> bitCount -= 8;
+        if (outputStream -> curSize == outputStream -> capacity && !flushOutputStream(outputStream)) {
+            continue;
+        }
+
+        outputStream -> buffer[outputStream -> curSize++] =
+                (unsigned char)(outputStream -> bitBuffer >> outputStream -> bitCount);
     }
+}
 
-    //Finally we're starting encoding
-    if (!transformingAndZip(codesTable)) {
-        return OUT_OF_MEMORY;
+void writeSymbol(OutputStream* outputStream, unsigned char symbol) {
+    if (outputStream -> curSize == outputStream -> capacity && !flushOutputStream(outputStream)) {
+        return;
     }
 
-    return SUCCESS;
+    outputStream -> buffer[outputStream -> curSize++] = symbol;
 }
 
-void readSymbolAndInsert(InputStream* input, Node* curNode) {
-    unsigned char result = 0;
-    for (int i = 0; i < 8; i++) {
-        if (isNewSymbol(input) && readSingleSymbol(input)) {
-            input -> buffer = getInBitArray(input -> current);
-        }
-
-        result = 2 * result + (input -> buffer[input -> curIndex] - '0');
-        input -> curIndex = (input -> curIndex + 1) % 8;
+//Seven bits per byte starting from the lowest ones, highest bit means that more bytes follow
+int getNumberSize(unsigned long long number) {
+    int size = 1;
+    while (number >= 0x80) {
+        number >>= 7;
+        size++;
     }
 
-    curNode -> symbol = result;
+    return size;
 }
 
-void readTree(InputStream* input, Node* root) {
-    if (isNewSymbol(input) && readSingleSymbol(input)) {
-        input -> buffer = getInBitArray(input -> current);
+void writeNumber(OutputStream* outputStream, unsigned long long number) {
+    assert(outputStream -> bitCount == 0);
+
+    while (number >= 0x80) {
+        writeSymbol(outputStream, (unsigned char)(number | 0x80));
+        number >>= 7;
     }
+    writeSymbol(outputStream, (unsigned char)number);
+}
 
-    int isCurrentNodeLeaf = (input -> buffer[input -> curIndex] == '1');
-    input -> curIndex = (input -> curIndex + 1) % 8;
-    if (isCurrentNodeLeaf) {
-        readSymbolAndInsert(input, root);
+void writeRawBytes(OutputStream* outputStream, const unsigned char* bytes, size_t count) {
+    assert(outputStream -> bitCount == 0);
 
-        return;
+    for (size_t i = 0; i < count; i++) {
+        writeSymbol(outputStream, bytes[i]);
     }
-
-    root -> left = (Node*)calloc(1, sizeof(Node));
-    root -> right = (Node*)calloc(1, sizeof(Node));
-    readTree(input, root -> left);
-    readTree(input, root -> right);
 }
 
-ExitCodes getDecodingData(int* count, Node* rootOfTree) {
-    if (fread(count, sizeof(int), 1, fileIn) == 0) {
-        return WRONG_INPUT;
-    }
-    if (count == 0) {
-        return SUCCESS;
-    }
+////////////////////////////////
 
-    InputStream* readingDecodingData = allocInputStream();
-    if (!readingDecodingData) {
-        return OUT_OF_MEMORY;
-    }
 
-    readTree(readingDecodingData, rootOfTree);
+/////Thread pool
+//Workers sleep until a task is given, then take its jobs one by one together with the thread
+//which has given it. runInPool() returns when all jobs of the task are done
+
+typedef ExitCodes (*PoolJob)(void* context, int index);
+
+struct _thread_pool {
+    pthread_t* threads;
+    int threadCount;
+    pthread_mutex_t lock;
+    pthread_cond_t taskGiven;
+    pthread_cond_t taskDone;
+    PoolJob job;
+    void* context;
+    int jobCount;
+    int nextJob;
+    int doneJobs;
+    int generation;
+    int isStopping;
+    ExitCodes result;
+};
 
-    free(readingDecodingData -> buffer);
-    free(readingDecodingData);
-    return SUCCESS;
-}
+//Is called and returns with the lock held
+void takeJobs(ThreadPool* pool) {
+    while (pool -> nextJob < pool -> jobCount) {
+        int index = pool -> nextJob++;
+
+        pthread_mutex_unlock(&pool -> lock);
+        ExitCodes result = pool -> job(pool -> context, index);
+        pthread_mutex_lock(&pool -> lock);
 
-void getSymbol(Node* curNode, InputStream* input) {
-    if (isNewSymbol(input) && readSingleSymbol(input)) {
-        input -> buffer = getInBitArray(input -> current);
+        if (result != SUCCESS && pool -> result == SUCCESS) {
+            pool -> result = result;
+        }
+        if (++pool -> doneJobs == pool -> jobCount) {
+            pthread_cond_signal(&pool -> taskDone);
+        }
     }
+}
 
-    switch (getCurBit(input)) {
-        case '0':
-            curNode = curNode -> left;
-            break;
-        case '1':
-            curNode = curNode -> right;
+void* workerLoop(void* argument) {
+    ThreadPool* pool = (ThreadPool*)argument;
+
+    pthread_mutex_lock(&pool -> lock);
+    int seenGeneration = pool -> generation;
+    while (true) {
+        while (!pool -> isStopping && pool -> generation == seenGeneration) {
+            pthread_cond_wait(&pool -> taskGiven, &pool -> lock);
+        }
+        if (pool -> isStopping) {
             break;
+        }
+
+        seenGeneration = pool -> generation;
+        takeJobs(pool);
     }
-    input -> curIndex = (input -> curIndex + 1) % 8;
+    pthread_mutex_unlock(&pool -> lock);
 
-    if (isLeaf(curNode)) {
-        fwrite(&curNode -> symbol, sizeof(unsigned char), 1, fileOut);
+    return NULL;
+}
 
-        return;
-    }
+int getProcessorCount() {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
 
-    getSymbol(curNode, input);
+    return count > 0 ? (int)count : 1;
 }
 
-ExitCodes unzip(int count, Node* root) {
-    InputStream* input = allocInputStream();
-    if (!input) {
-        return OUT_OF_MEMORY;
+void destroyThreadPool(ThreadPool* pool) {
+    pthread_mutex_lock(&pool -> lock);
+    pool -> isStopping = true;
+    pthread_cond_broadcast(&pool -> taskGiven);
+    pthread_mutex_unlock(&pool -> lock);
+
+    for (int i = 0; i < pool -> threadCount; i++) {
+        pthread_join(pool -> threads[i], NULL);
     }
 
-    Node* newNode = (Node*)calloc(1, sizeof(Node));
-    if (!newNode) {
-        free(input -> buffer);
-        free(input);
-        return OUT_OF_MEMORY;
+    pthread_cond_destroy(&pool -> taskDone);
+    pthread_cond_destroy(&pool -> taskGiven);
+    pthread_mutex_destroy(&pool -> lock);
+    free(pool -> threads);
+    free(pool);
+}
+
+//The calling thread works too, so threadCount - 1 workers are started
+ThreadPool* createThreadPool(int threadCount) {
+    ThreadPool* pool = (ThreadPool*)calloc(1, sizeof(ThreadPool));
+    if (!pool) {
+        return NULL;
+    }
+    pool -> threads = (pthread_t*)calloc((size_t)(threadCount > 1 ? threadCount - 1 : 1), sizeof(pthread_t));
+    if (!pool -> threads) {
+        free(pool);
+        return NULL;
     }
 
-    for (int i = 0; i < count; i++) {
-        memcpy(newNode, root, sizeof(Node));
-        getSymbol(newNode, input);
-        memcpy(newNode, root, sizeof(Node));
+    pthread_mutex_init(&pool -> lock, NULL);
+    pthread_cond_init(&pool -> taskGiven, NULL);
+    pthread_cond_init(&pool -> taskDone, NULL);
+
+    for (int i = 0; i < threadCount - 1; i++) {
+        if (pthread_create(&pool -> threads[i], NULL, workerLoop, pool) != 0) {
+            break;
+        }
+        pool -> threadCount++;
     }
 
-    free(newNode);
-    free(input -> buffer);
-    free(input);
-    return SUCCESS;
+    return pool;
 }
 
-ExitCodes decoding() {
-    //Firstly we have to read encoded data for decoding
+ExitCodes runInPool(ThreadPool* pool, PoolJob job, void* context, int jobCount) {
+    if (jobCount == 0) {
+        return SUCCESS;
+    }
+
+    pthread_mutex_lock(&pool -> lock);
+    pool -> job = job;
+    pool -> context = context;
+    pool -> jobCount = jobCount;
+    pool -> nextJob = 0;
+    pool -> doneJobs = 0;
+    pool -> result = SUCCESS;
+    pool -> generation++;
+    pthread_cond_broadcast(&pool -> taskGiven);
+
+    takeJobs(pool);
+    while (pool -> doneJobs < pool -> jobCount) {
+        pthread_cond_wait(&pool -> taskDone, &pool -> lock);
+    }
+    ExitCodes result = pool -> result;
+    pthread_mutex_unlock(&pool -> lock);
+
+    return result;
+}
+
+//////////////////
+
+/////Encoding
+
+typedef enum {
+    ORDER0_MODE,
+    ORDER1_MODE,
+    RANS_MODE
+} BlockMode;
+
+struct _encoder_options {
+    int lengthLimit;
+    int useContexts;
+    int useRans;
+};
+
+//Equal frequencies are ordered by symbol, so the same input always gives the same tree
+int compareNodes(const void** a, const void** b) {
+    const Node** first = (const Node**)a;
+    const Node** second = (const Node**)b;
+
+    if ((*first) -> freq != (*second) -> freq) {
+        return (*first) -> freq < (*second) -> freq ? -1 : 1;
+    }
+
+    return (int)(*first) -> symbol - (int)(*second) -> symbol;
+}
+
+/////Histogram
+//Counting into one table stalls on the same counter when a byte repeats: every increment waits for
+//the previous store. Bytes are spread over HISTOGRAM_LANES tables by their position and summed up at
+//the end. With AVX2 a run of 32 equal bytes is counted at once, skewed data has plenty of them
+
+#define HISTOGRAM_LANES 4
+//Counters of the lanes are 32-bit, longer data is counted by parts
+#define HISTOGRAM_PART_SIZE (1 << 30)
+
+typedef unsigned int Histogram[HISTOGRAM_LANES][NUMBER_OF_CHARS];
+
+//Takes 8 bytes at once, every lane gets two of them
+void countWord(Histogram counts, const unsigned char* data) {
+    unsigned long long word;
+    memcpy(&word, data, sizeof(word));
+
+    for (int i = 0; i < 8; i++) {
+        counts[i % HISTOGRAM_LANES][(word >> (8 * i)) & 0xFF]++;
+    }
+}
+
+void countPart(const unsigned char* data, size_t size, Histogram counts) {
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        countWord(counts, data + i);
+    }
+    for (; i < size; i++) {
+        counts[0][data[i]]++;
+    }
+}
+
+#ifdef HAS_X86_KERNELS
+__attribute__((target("avx2")))
+void countPartAvx2(const unsigned char* data, size_t size, Histogram counts) {
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256i bytes = _mm256_loadu_si256((const __m256i*)(data + i));
+        __m256i first = _mm256_set1_epi8((char)data[i]);
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, first)) == -1) {
+            counts[0][data[i]] += 32;
+            continue;
+        }
+
+        for (int j = 0; j < 32; j += 8) {
+            countWord(counts, data + i + j);
+        }
+    }
+    countPart(data + i, size - i, counts);
+}
+#endif
+
+typedef void (*HistogramKernel)(const unsigned char* data, size_t size, Histogram counts);
+
+HistogramKernel getHistogramKernel() {
+#ifdef HAS_X86_KERNELS
+    if (__builtin_cpu_supports("avx2")) {
+        return countPartAvx2;
+    }
+#endif
+
+    return countPart;
+}
+
+void countFrequencies(const unsigned char* data, size_t size, unsigned long long* frequencies) {
+    HistogramKernel kernel = getHistogramKernel();
+
+    while (size > 0) {
+        size_t part = size < HISTOGRAM_PART_SIZE ? size : HISTOGRAM_PART_SIZE;
+        Histogram counts = {{0}};
+        kernel(data, part, counts);
+
+        for (int i = 0; i < NUMBER_OF_CHARS; i++) {
+            for (int j = 0; j < HISTOGRAM_LANES; j++) {
+                frequencies[i] += counts[j][i];
+            }
+        }
+
+        data += part;
+        size -= part;
+    }
+}
+
+//////////////////
+
+/////Two-queue construction
+//Leaves are sorted once, merged nodes appear in non-decreasing order of frequency by themselves,
+//so the two smallest nodes are always at the heads of these two queues: O(n log n) for sorting
+//and O(n) for merging
+
+typedef struct _merge_queues MergeQueues;
+
+struct _merge_queues {
+    Node** leaves;
+    int leafHead;
+    int leafCount;
+    Node* merged;
+    int mergedHead;
+    int mergedCount;
+};
+
+//On equal frequencies a leaf goes first, that keeps codes as short as possible
+Node* popSmallest(MergeQueues* queues) {
+    if (queues -> leafHead < queues -> leafCount && (queues -> mergedHead == queues -> mergedCount ||
+            queues -> leaves[queues -> leafHead] -> freq <= queues -> merged[queues -> mergedHead].freq)) {
+        return queues -> leaves[queues -> leafHead++];
+    }
+
+    return &queues -> merged[queues -> mergedHead++];
+}
+
+//Internal nodes are taken from mergedNodes, there must be place for count - 1 of them.
+//Leaves with non-zero frequency end up at the end of arr sorted, their number is returned;
+//the root is the last merged node
+int buildTree(Node** arr, int count, Node* mergedNodes) {
+    qsort(arr, (size_t)count, sizeof(Node*), (__compar_fn_t)compareNodes);
+
+    int indexOfBeginning = 0;
+    while (indexOfBeginning < count && arr[indexOfBeginning] -> freq == 0) {
+        indexOfBeginning++;
+    }
+
+    MergeQueues queues = {arr + indexOfBeginning, 0, count - indexOfBeginning, mergedNodes, 0, 0};
+    for (int i = 0; i < queues.leafCount - 1; i++) {
+        Node* newNode = &mergedNodes[queues.mergedCount];
+        newNode -> left = popSmallest(&queues);
+        newNode -> right = popSmallest(&queues);
+        newNode -> freq = newNode -> left -> freq + newNode -> right -> freq;
+        queues.mergedCount++;
+    }
+
+    return queues.leafCount;
+}
+
+//Every merged node is created after its children, so going from the root backwards gives
+//depths of all nodes without recursion
+int getTreeDepths(int leafCount, Node* mergedNodes, unsigned char* lengths) {
+    int depth[NUMBER_OF_CHARS - 1];
+    int maxDepth = 0;
+
+    memset(lengths, 0, NUMBER_OF_CHARS);
+    if (leafCount < 2) {
+        return 0;
+    }
+
+    depth[leafCount - 2] = 0;
+    for (int i = leafCount - 2; i >= 0; i--) {
+        Node* children[2] = {mergedNodes[i].left, mergedNodes[i].right};
+        for (int j = 0; j < 2; j++) {
+            if (children[j] >= mergedNodes && children[j] < mergedNodes + leafCount - 1) {
+                depth[children[j] - mergedNodes] = depth[i] + 1;
+            } else {
+                lengths[children[j] -> symbol] = (unsigned char)(depth[i] + 1);
+                if (depth[i] + 1 > maxDepth) {
+                    maxDepth = depth[i] + 1;
+                }
+            }
+        }
+    }
+
+    return maxDepth;
+}
+
+//////////////////////////////
+
+/////Length limiting
+//Package-merge: list of a level is the leaves merged with pairs of the previous level's list.
+//Taking 2n - 2 cheapest items of the last list gives optimal lengths not longer than limit:
+//every leaf gets one bit for each level where it's taken, packages taken at a level say how many
+//items are taken at the previous one
+
+void packageMerge(Node** leaves, int leafCount, int limit, unsigned char* lengths) {
+    unsigned long long weights[2][2 * NUMBER_OF_CHARS];
+    unsigned char isLeafItem[MAX_CODE_LENGTH_LIMIT][2 * NUMBER_OF_CHARS];
+    int size = leafCount;
+
+    for (int i = 0; i < leafCount; i++) {
+        weights[0][i] = leaves[i] -> freq;
+        isLeafItem[0][i] = true;
+    }
+
+    for (int level = 1; level < limit; level++) {
+        unsigned long long* previous = weights[(level - 1) % 2];
+        unsigned long long* current = weights[level % 2];
+        int packages = size / 2;
+        int leafIndex = 0, packageIndex = 0;
+
+        size = 0;
+        while (leafIndex < leafCount || packageIndex < packages) {
+            unsigned long long packageWeight = packageIndex < packages ?
+                    previous[2 * packageIndex] + previous[2 * packageIndex + 1] : 0;
+            if (packageIndex == packages || (leafIndex < leafCount && leaves[leafIndex] -> freq <= packageWeight)) {
+                current[size] = leaves[leafIndex++] -> freq;
+                isLeafItem[level][size++] = true;
+            } else {
+                current[size] = packageWeight;
+                isLeafItem[level][size++] = false;
+                packageIndex++;
+            }
+        }
+    }
+
+    int taken = 2 * leafCount - 2;
+    for (int i = 0; i < leafCount; i++) {
+        lengths[leaves[i] -> symbol] = 0;
+    }
+    for (int level = limit - 1; level >= 0; level--) {
+        int takenLeaves = 0;
+        for (int i = 0; i < taken; i++) {
+            takenLeaves += isLeafItem[level][i];
+        }
+
+        //Leaves are merged in sorted order, so the lightest ones are taken
+        for (int i = 0; i < takenLeaves; i++) {
+            lengths[leaves[i] -> symbol]++;
+        }
+        taken = 2 * (taken - takenLeaves);
+    }
+}
+
+/////////////////////
+
+typedef struct _filling_step FillingStep;
+
+struct _filling_step {
+    Node* node;
+    Code code;
+};
+
+//Code is kept as a number whose highest bit is the first step from the root. Tree is walked with
+//its own stack: right child waits while the left one is walked, so there is one waiting node per level
+int startFilling(Code* table, Node* root) {
+    FillingStep stack[MAX_CODE_LENGTH + 2];
+    int stackSize = 0;
+    stack[stackSize++] = (FillingStep){root, {0, 0}};
+
+    while (stackSize > 0) {
+        FillingStep step = stack[--stackSize];
+        if (isLeaf(step.node)) {
+            table[step.node -> symbol] = step.code;
+            continue;
+        }
+        if (step.code.length == MAX_CODE_LENGTH) {
+            return false;
+        }
+
+        int length = step.code.length + 1;
+        stack[stackSize++] = (FillingStep){step.node -> right, {(step.code.bits << 1) | 1, length}};
+        stack[stackSize++] = (FillingStep){step.node -> left, {step.code.bits << 1, length}};
+    }
+
+    return true;
+}
+
+/////Canonical codes
+//Only lengths of codes are stored. Symbols are ordered by (length, symbol) and every next code is
+//the previous one plus one, shifted left when the length grows, so lengths define codes completely
+
+struct _code_lengths {
+    unsigned char lengths[NUMBER_OF_CHARS];
+    unsigned char symbols[NUMBER_OF_CHARS];
+    int symbolCount;
+    int maxLength;
+};
+
+//Symbols must be given in increasing order, the sort is stable
+void sortCanonically(CodeLengths* codeLengths) {
+    unsigned char sorted[NUMBER_OF_CHARS];
+    int sortedCount = 0;
+
+    codeLengths -> maxLength = 0;
+    for (int i = 0; i < codeLengths -> symbolCount; i++) {
+        if (codeLengths -> lengths[codeLengths -> symbols[i]] > codeLengths -> maxLength) {
+            codeLengths -> maxLength = codeLengths -> lengths[codeLengths -> symbols[i]];
+        }
+    }
+
+    for (int length = 0; length <= codeLengths -> maxLength; length++) {
+        for (int i = 0; i < codeLengths -> symbolCount; i++) {
+            if (codeLengths -> lengths[codeLengths -> symbols[i]] == length) {
+                sorted[sortedCount++] = codeLengths -> symbols[i];
+            }
+        }
+    }
+
+    memcpy(codeLengths -> symbols, sorted, (size_t)sortedCount);
+}
+
+//Fails if lengths can't belong to a prefix code
+int assignCanonicalCodes(const CodeLengths* codeLengths, Code* codes) {
+    unsigned long long code = 0;
+    int curLength = 0;
+
+    memset(codes, 0, NUMBER_OF_CHARS * sizeof(Code));
+    for (int i = 0; i < codeLengths -> symbolCount; i++) {
+        unsigned char symbol = codeLengths -> symbols[i];
+        int length = codeLengths -> lengths[symbol];
+        if (length == 0 && codeLengths -> symbolCount > 1) {
+            return false;
+        }
+
+        code <<= length - curLength;
+        curLength = length;
+        if (code >> length) {
+            return false;
+        }
+
+        codes[symbol] = (Code){code, length};
+        code++;
+    }
+
+    return true;
+}
+
+//Lengths come from the tree unless it's deeper than limit, then they are rebuilt by package-merge
+void getCodeLengths(Node** leaves, int leafCount, Node* mergedNodes, int lengthLimit, CodeLengths* codeLengths) {
+    if (getTreeDepths(leafCount, mergedNodes, codeLengths -> lengths) > lengthLimit) {
+        packageMerge(leaves, leafCount, lengthLimit, codeLengths -> lengths);
+    }
+
+    int isPresent[NUMBER_OF_CHARS] = {0};
+    for (int i = 0; i < leafCount; i++) {
+        isPresent[leaves[i] -> symbol] = true;
+    }
+
+    codeLengths -> symbolCount = 0;
+    for (int i = 0; i < NUMBER_OF_CHARS; i++) {
+        if (isPresent[i]) {
+            codeLengths -> symbols[codeLengths -> symbolCount++] = (unsigned char)i;
+        }
+    }
+
+    sortCanonically(codeLengths);
+}
+
+//Builds the tree for frequencies of all symbols and takes lengths of its codes
+void makeCodeLengths(TreeMemory* memory, const unsigned long long* frequencies, int lengthLimit,
+        CodeLengths* codeLengths) {
+    initNodePointerArray(memory, frequencies);
+
+    int leafCount = buildTree(memory -> arrayOfNodes, NUMBER_OF_CHARS, memory -> mergedNodes);
+    getCodeLengths(memory -> arrayOfNodes + NUMBER_OF_CHARS - leafCount, leafCount, memory -> mergedNodes,
+            lengthLimit, codeLengths);
+}
+
+unsigned long long getDataBits(const unsigned long long* frequencies, const CodeLengths* codeLengths) {
+    unsigned long long bits = 0;
+    for (int i = 0; i < NUMBER_OF_CHARS; i++) {
+        bits += frequencies[i] * codeLengths -> lengths[i];
+    }
+
+    return bits;
+}
+
+int bitsForValue(int value) {
+    int bits = 0;
+    while ((1 << bits) <= value) {
+        bits++;
+    }
+
+    return bits;
+}
+
+//Count of codes of the length which is less than maximal is less than 2^length, the last one is
+//not stored at all: it's the rest of symbols
+int countBits(int length) {
+    return length < 8 ? length : 8;
+}
+
+//There are two layouts: list of symbols in canonical order with number of codes of every length,
+//or plain table of lengths for all symbols, the shorter one is written. Size is given in bits,
+//isTable may be NULL
+int getCodeLengthsBits(const CodeLengths* codeLengths, int* isTable) {
+    int listBits = 8 + 8 * codeLengths -> symbolCount;
+    for (int length = 1; length < codeLengths -> maxLength; length++) {
+        listBits += countBits(length);
+    }
+    int tableBits = NUMBER_OF_CHARS * bitsForValue(codeLengths -> maxLength);
+    int isTableShorter = codeLengths -> maxLength > 0 && tableBits < listBits;
+
+    if (isTable) {
+        *isTable = isTableShorter;
+    }
+
+    return 1 + LENGTH_BITS + (isTableShorter ? tableBits : listBits);
+}
+
+void writeCodeLengths(OutputStream* outputStream, const CodeLengths* codeLengths) {
+    int lengthCount[MAX_CODE_LENGTH + 1] = {0};
+    for (int i = 0; i < codeLengths -> symbolCount; i++) {
+        lengthCount[codeLengths -> lengths[codeLengths -> symbols[i]]]++;
+    }
+
+    int isTable;
+    getCodeLengthsBits(codeLengths, &isTable);
+    int lengthBits = bitsForValue(codeLengths -> maxLength);
+
+    writeBits(outputStream, (unsigned long long)isTable, 1);
+    writeBits(outputStream, (unsigned long long)codeLengths -> maxLength, LENGTH_BITS);
+    if (isTable) {
+        for (int i = 0; i < NUMBER_OF_CHARS; i++) {
+            writeBits(outputStream, codeLengths -> lengths[i], lengthBits);
+        }
+
+        return;
+    }
+
+    writeBits(outputStream, (unsigned long long)(codeLengths -> symbolCount - 1), 8);
+    for (int length = 1; length < codeLengths -> maxLength; length++) {
+        writeBits(outputStream, (unsigned long long)lengthCount[length], countBits(length));
+    }
+    for (int i = 0; i < codeLengths -> symbolCount; i++) {
+        writeBits(outputStream, codeLengths -> symbols[i], 8);
+    }
+}
+
+//////////////////
+
+void transformingAndZip(const unsigned char* data, size_t size, const Code* codes, OutputStream* outputStream) {
+    for (size_t i = 0; i < size; i++) {
+        writeBits(outputStream, codes[data[i]].bits, codes[data[i]].length);
+    }
+    writePadding(outputStream);
+}
+
+/////////////
+
+/////Order-1 contexts
+//Every symbol is coded with the table of the byte before it, the first byte of a block follows
+//zero. Header has a bit for every context and code lengths of the used ones; context with the
+//only symbol costs nothing in data. Block takes this mode only if it comes out shorter
+
+typedef struct _context_model ContextModel;
+
+struct _context_model {
+    unsigned long long frequencies[NUMBER_OF_CHARS][NUMBER_OF_CHARS];
+    CodeLengths codeLengths[NUMBER_OF_CHARS];
+    Code codes[NUMBER_OF_CHARS][NUMBER_OF_CHARS];
+    int isUsed[NUMBER_OF_CHARS];
+};
+
+void countContextFrequencies(const unsigned char* data, size_t size, ContextModel* model) {
+    unsigned char previous = 0;
+    for (size_t i = 0; i < size; i++) {
+        model -> frequencies[previous][data[i]]++;
+        previous = data[i];
+    }
+}
+
+//Returns the size of the block in bits: header and data
+unsigned long long makeContextModel(TreeMemory* memory, int lengthLimit, ContextModel* model) {
+    unsigned long long bits = NUMBER_OF_CHARS;
+
+    for (int i = 0; i < NUMBER_OF_CHARS; i++) {
+        model -> isUsed[i] = false;
+        for (int j = 0; j < NUMBER_OF_CHARS && !model -> isUsed[i]; j++) {
+            model -> isUsed[i] = model -> frequencies[i][j] > 0;
+        }
+        if (!model -> isUsed[i]) {
+            continue;
+        }
+
+        makeCodeLengths(memory, model -> frequencies[i], lengthLimit, &model -> codeLengths[i]);
+        assignCanonicalCodes(&model -> codeLengths[i], model -> codes[i]);
+        bits += getCodeLengthsBits(&model -> codeLengths[i], NULL) +
+                getDataBits(model -> frequencies[i], &model -> codeLengths[i]);
+    }
+
+    return bits;
+}
+
+void writeContextModel(OutputStream* outputStream, const ContextModel* model) {
+    for (int i = 0; i < NUMBER_OF_CHARS; i++) {
+        writeBits(outputStream, (unsigned long long)model -> isUsed[i], 1);
+        if (model -> isUsed[i]) {
+            writeCodeLengths(outputStream, &model -> codeLengths[i]);
+        }
+    }
+}
+
+void zipWithContexts(const unsigned char* data, size_t size, const ContextModel* model, OutputStream* outputStream) {
+    unsigned char previous = 0;
+    for (size_t i = 0; i < size; i++) {
+        writeBits(outputStream, model -> codes[previous][data[i]].bits, model -> codes[previous][data[i]].length);
+        previous = data[i];
+    }
+    writePadding(outputStream);
+}
+
+//////////////////////
+
+/////rANS
+//Asymmetric numeral systems spend fractions of a bit on a symbol, so skewed data comes out
+//shorter than with Huffman. Frequencies are scaled to PROB_SCALE, every state is kept in
+//[RANS_LOW, RANS_LOW << 8) and goes out by bytes. RANS_STATES states take symbols in turn, so
+//their decoding chains are independent and run in parallel on the CPU. Encoder goes from the end
+//of the block writing bytes backwards, decoder reads them forwards.
+//Block is the frequency table (padded up to the whole byte), initial states and the bytes
+
+#define PROB_BITS 12
+#define PROB_SCALE (1 << PROB_BITS)
+#define RANS_LOW (1u << 23)
+#define RANS_STATES 4
+
+typedef struct _rans_model RansModel;
+typedef struct _rans_block RansBlock;
+
+struct _rans_model {
+    unsigned int frequencies[NUMBER_OF_CHARS];
+    unsigned int starts[NUMBER_OF_CHARS];
+    int symbolCount;
+};
+
+struct _rans_block {
+    RansModel model;
+    const unsigned char* bytes;
+    size_t size;
+};
+
+//Every present symbol keeps at least 1, the sum is exactly PROB_SCALE
+void normalizeFrequencies(const unsigned long long* counts, size_t total, RansModel* model) {
+    unsigned int sum = 0;
+    model -> symbolCount = 0;
+    for (int i = 0; i < NUMBER_OF_CHARS; i++) {
+        model -> frequencies[i] = 0;
+        if (counts[i]) {
+            model -> symbolCount++;
+            model -> frequencies[i] = (unsigned int)(counts[i] * PROB_SCALE / total);
+            if (model -> frequencies[i] == 0) {
+                model -> frequencies[i] = 1;
+            }
+        }
+        sum += model -> frequencies[i];
+    }
+
+    //Rounding is corrected on the biggest frequencies, they lose the least
+    while (sum != PROB_SCALE) {
+        int biggest = 0;
+        for (int i = 1; i < NUMBER_OF_CHARS; i++) {
+            if (model -> frequencies[i] > model -> frequencies[biggest]) {
+                biggest = i;
+            }
+        }
+
+        if (sum < PROB_SCALE) {
+            model -> frequencies[biggest] += PROB_SCALE - sum;
+            sum = PROB_SCALE;
+        } else {
+            unsigned int excess = sum - PROB_SCALE;
+            unsigned int taken = model -> frequencies[biggest] - 1 < excess ? model -> frequencies[biggest] - 1 : excess;
+            if (taken == 0) {
+                taken = 1;
+            }
+            model -> frequencies[biggest] -= taken;
+            sum -= taken;
+        }
+    }
+
+    unsigned int start = 0;
+    for (int i = 0; i < NUMBER_OF_CHARS; i++) {
+        model -> starts[i] = start;
+        start += model -> frequencies[i];
+    }
+}
+
+void writeRansModel(OutputStream* outputStream, const RansModel* model) {
+    writeBits(outputStream, (unsigned long long)(model -> symbolCount - 1), 8);
+    for (int i = 0; i < NUMBER_OF_CHARS; i++) {
+        if (model -> frequencies[i]) {
+            writeBits(outputStream, (unsigned long long)i, 8);
+            writeBits(outputStream, model -> frequencies[i] - 1, PROB_BITS);
+        }
+    }
+}
+
+//Bytes are put backwards before end, their start is returned
+unsigned char* ransEncode(const unsigned char* data, size_t size, const RansModel* model, unsigned char* end) {
+    unsigned int states[RANS_STATES];
+    for (int i = 0; i < RANS_STATES; i++) {
+        states[i] = RANS_LOW;
+    }
+
+    unsigned char* place = end;
+    for (size_t i = size; i-- > 0;) {
+        unsigned int* state = &states[i % RANS_STATES];
+        unsigned int frequency = model -> frequencies[data[i]];
+
+        //State must stay in range after the symbol is added
+        unsigned int limit = ((RANS_LOW >> PROB_BITS) << 8) * frequency;
+        while (*state >= limit) {
+            *--place = (unsigned char)*state;
+            *state >>= 8;
+        }
+
+        *state = ((*state / frequency) << PROB_BITS) + *state % frequency + model -> starts[data[i]];
+    }
+
+    //Decoder takes the states first, the highest byte of every state goes first
+    for (int i = RANS_STATES - 1; i >= 0; i--) {
+        for (int j = 0; j < 4; j++) {
+            *--place = (unsigned char)(states[i] >> (8 * j));
+        }
+    }
+
+    return place;
+}
+
+//Block is coded to memory of the arena, so it can be compared with the other modes before it's written.
+//Size of the whole block in bits is returned, zero means there is no memory
+unsigned long long makeRansBlock(const unsigned char* data, size_t size, const unsigned long long* frequencies,
+        Arena* arena, RansBlock* block) {
+    normalizeFrequencies(frequencies, size, &block -> model);
+
+    //Symbol never takes more than PROB_BITS bits
+    size_t capacity = size * 2 + 4 * RANS_STATES;
+    unsigned char* buffer = (unsigned char*)arenaAlloc(arena, capacity);
+    if (!buffer) {
+        return 0;
+    }
+
+    block -> bytes = ransEncode(data, size, &block -> model, buffer + capacity);
+    block -> size = (size_t)(buffer + capacity - block -> bytes);
+
+    unsigned long long modelBits = 8 + (unsigned long long)block -> model.symbolCount * (8 + PROB_BITS);
+    return (modelBits + 7) / 8 * 8 + block -> size * 8;
+}
+
+void writeRansBlock(OutputStream* outputStream, const RansBlock* block, size_t* headerSize) {
+    writeRansModel(outputStream, &block -> model);
+    writePadding(outputStream);
+    *headerSize = outputStream -> curSize + 4 * RANS_STATES;
+
+    writeRawBytes(outputStream, block -> bytes, block -> size);
+}
+
+////////////
+
+//Block is written as its mode, code lengths and data, the last two are padded up to the whole
+//byte; the shortest of the allowed modes is taken. Output has to be empty memory stream, headerSize
+//is set to the size of mode and code lengths
+ExitCodes encodeBlock(const unsigned char* data, size_t size, const EncoderOptions* options, Arena* arena,
+        OutputStream* outputStream, size_t* headerSize) {
+    //First of all we have to build tree
+    TreeMemory memory;
+    unsigned long long* frequencies = (unsigned long long*)arenaAlloc(arena,
+            NUMBER_OF_CHARS * sizeof(unsigned long long));
+    if (!allocTreeMemory(&memory, arena) || !frequencies) {
+        return OUT_OF_MEMORY;
+    }
+    countFrequencies(data, size, frequencies);
+
+    CodeLengths codeLengths;
+    makeCodeLengths(&memory, frequencies, options -> lengthLimit, &codeLengths);
+
+    BlockMode mode = ORDER0_MODE;
+    unsigned long long bestBits = getCodeLengthsBits(&codeLengths, NULL) + getDataBits(frequencies, &codeLengths);
+
+    ContextModel* model = NULL;
+    if (options -> useContexts) {
+        model = (ContextModel*)arenaAlloc(arena, sizeof(ContextModel));
+        if (!model) {
+            return OUT_OF_MEMORY;
+        }
+        countContextFrequencies(data, size, model);
+
+        unsigned long long contextBits = makeContextModel(&memory, options -> lengthLimit, model);
+        if (contextBits < bestBits) {
+            mode = ORDER1_MODE;
+            bestBits = contextBits;
+        }
+    }
+
+    RansBlock* ransBlock = NULL;
+    if (options -> useRans && size > 0) {
+        ransBlock = (RansBlock*)arenaAlloc(arena, sizeof(RansBlock));
+        unsigned long long ransBits = ransBlock ? makeRansBlock(data, size, frequencies, arena, ransBlock) : 0;
+        if (!ransBits) {
+            return OUT_OF_MEMORY;
+        }
+
+        if (ransBits < bestBits) {
+            mode = RANS_MODE;
+        }
+    }
+
+    writeBits(outputStream, mode, 8);
+    if (mode == RANS_MODE) {
+        writeRansBlock(outputStream, ransBlock, headerSize);
+    } else if (mode == ORDER1_MODE) {
+        writeContextModel(outputStream, model);
+        writePadding(outputStream);
+        *headerSize = outputStream -> curSize;
+
+        zipWithContexts(data, size, model, outputStream);
+    } else {
+        //Secondly we should get table of codes to encode symbols for O(1)
+        Code codesTable[NUMBER_OF_CHARS];
+        assignCanonicalCodes(&codeLengths, codesTable);
+
+        //Writing data for decoding
+        writeCodeLengths(outputStream, &codeLengths);
+        writePadding(outputStream);
+        *headerSize = outputStream -> curSize;
+
+        //Finally we're starting encoding
+        transformingAndZip(data, size, codesTable, outputStream);
+    }
+
+    return outputStream -> isBroken ? getOutputError(outputStream) : SUCCESS;
+}
+
+/////Decoding tables
+//Every table resolves DECODE_BITS bits at once: an entry either holds a decoded symbol and the
+//length of its code, or (length == 0) the index of the next table for codes longer than that.
+//Entry with neither of them belongs to no code
+
+#define DECODE_BITS 10
+#define DECODE_TABLE_SIZE (1 << DECODE_BITS)
+
+typedef struct _decode_entry DecodeEntry;
+typedef struct _decode_tables DecodeTables;
+
+struct _decode_entry {
+    unsigned short next;
+    unsigned char symbol;
+    unsigned char length;
+};
+
+//Tables live in the arena, old entries are left there when they grow
+struct _decode_tables {
+    Arena* arena;
+    DecodeEntry* entries;
     int count;
-    Node* tree = (Node*)calloc(1, sizeof(Node));
+    int capacity;
+};
+
+int addDecodeTable(DecodeTables* tables) {
+    //Index of a table has to fit into the entry
+    if (tables -> count > USHRT_MAX) {
+        return -1;
+    }
+
+    if (tables -> count == tables -> capacity) {
+        int newCapacity = tables -> capacity ? 2 * tables -> capacity : 4;
+        DecodeEntry* newEntries = (DecodeEntry*)arenaAlloc(tables -> arena,
+                (size_t)newCapacity * DECODE_TABLE_SIZE * sizeof(DecodeEntry));
+        if (!newEntries) {
+            return -1;
+        }
+
+        if (tables -> entries) {
+            memcpy(newEntries, tables -> entries, (size_t)tables -> count * DECODE_TABLE_SIZE * sizeof(DecodeEntry));
+        }
+        tables -> entries = newEntries;
+        tables -> capacity = newCapacity;
+    }
+
+    return tables -> count++;
+}
+
+ExitCodes insertDecodeCode(DecodeTables* tables, int root, unsigned char symbol, Code code) {
+    int table = root;
+    unsigned long long bits = code.bits;
+    int length = code.length;
+
+    while (length > DECODE_BITS) {
+        length -= DECODE_BITS;
+        size_t index = (size_t)table * DECODE_TABLE_SIZE + (size_t)(bits >> length);
+        if (tables -> entries[index].length) {
+            return WRONG_INPUT;
+        }
+
+        if (!tables -> entries[index].next) {
+            int subTable = addDecodeTable(tables);
+            if (subTable < 0) {
+                return OUT_OF_MEMORY;
+            }
+
+            tables -> entries[index] = (DecodeEntry){(unsigned short)subTable, 0, 0};
+        }
+
+        table = tables -> entries[index].next;
+        bits &= (1ULL << length) - 1;
+    }
+
+    int shift = DECODE_BITS - length;
+    DecodeEntry* first = tables -> entries + (size_t)table * DECODE_TABLE_SIZE + (size_t)(bits << shift);
+    for (int i = 0; i < (1 << shift); i++) {
+        first[i] = (DecodeEntry){0, symbol, (unsigned char)length};
+    }
+
+    return SUCCESS;
+}
+
+//Tables of one set of codes are added, root is set to the index of the first of them
+ExitCodes buildDecodeTables(DecodeTables* tables, const Code* codes, const unsigned char* symbols,
+        int symbolCount, int* root) {
+    if ((*root = addDecodeTable(tables)) < 0) {
+        return OUT_OF_MEMORY;
+    }
+
+    for (int i = 0; i < symbolCount; i++) {
+        ExitCodes curAction;
+        if ((curAction = insertDecodeCode(tables, *root, symbols[i], codes[symbols[i]])) != SUCCESS) {
+            return curAction;
+        }
+    }
+
+    return SUCCESS;
+}
+
+//Reads one code starting from the root table, fails on codes which aren't in the tables
+int decodeSymbol(InputStream* input, const DecodeTables* tables, int root, DecodeEntry* entry) {
+    int table = root;
+    do {
+        if (input -> bitCount < DECODE_BITS) {
+            refillBits(input);
+        }
+
+        *entry = tables -> entries[(size_t)table * DECODE_TABLE_SIZE + peekBits(input, DECODE_BITS)];
+        int used = entry -> length ? entry -> length : DECODE_BITS;
+        if ((!entry -> length && !entry -> next) || used > input -> bitCount) {
+            return false;
+        }
+
+        skipBits(input, used);
+        table = entry -> next;
+    } while (!entry -> length);
+
+    return true;
+}
+
+//////////////////
+
+ExitCodes readCodeLengths(InputStream* input, CodeLengths* codeLengths) {
+    unsigned int isTable, maxLength, value;
+    if (!readBits(input, 1, &isTable) || !readBits(input, LENGTH_BITS, &maxLength)) {
+        return WRONG_INPUT;
+    }
+
+    codeLengths -> symbolCount = 0;
+    memset(codeLengths -> lengths, 0, NUMBER_OF_CHARS);
+    if (isTable) {
+        //Encoder never writes a table of empty codes, and zero bits per length can't be read
+        if (maxLength == 0) {
+            return WRONG_INPUT;
+        }
+        int lengthBits = bitsForValue((int)maxLength);
+        for (int i = 0; i < NUMBER_OF_CHARS; i++) {
+            if (!readBits(input, lengthBits, &value) || value > maxLength) {
+                return WRONG_INPUT;
+            }
+
+            codeLengths -> lengths[i] = (unsigned char)value;
+            if (value) {
+                codeLengths -> symbols[codeLengths -> symbolCount++] = (unsigned char)i;
+            }
+        }
+        if (codeLengths -> symbolCount == 0) {
+            return WRONG_INPUT;
+        }
+
+        sortCanonically(codeLengths);
+        return SUCCESS;
+    }
+
+    if (!readBits(input, 8, &value)) {
+        return WRONG_INPUT;
+    }
+    int symbolCount = (int)value + 1;
+
+    int lengthCount[MAX_CODE_LENGTH + 1] = {0};
+    int rest = symbolCount;
+    for (int length = 1; length < (int)maxLength; length++) {
+        if (!readBits(input, countBits(length), &value)) {
+            return WRONG_INPUT;
+        }
+
+        lengthCount[length] = (int)value;
+        rest -= (int)value;
+    }
+    if (rest < 1 || (maxLength == 0 && symbolCount > 1)) {
+        return WRONG_INPUT;
+    }
+    lengthCount[maxLength] = rest;
+
+    int isPresent[NUMBER_OF_CHARS] = {0};
+    int length = 0;
+    for (int i = 0; i < symbolCount; i++) {
+        while (lengthCount[length] == 0) {
+            length++;
+        }
+        lengthCount[length]--;
+
+        if (!readBits(input, 8, &value) || isPresent[value]) {
+            return WRONG_INPUT;
+        }
+
+        isPresent[value] = true;
+        codeLengths -> lengths[value] = (unsigned char)length;
+        codeLengths -> symbols[codeLengths -> symbolCount++] = (unsigned char)value;
+    }
+    codeLengths -> maxLength = (int)maxLength;
+
+    return SUCCESS;
+}
+
+//Tree of the old format, leaves are collected in symbols
+//Tree goes in preorder. Nodes which are not read yet wait on the stack, every one of them needs
+//a leaf of its own, so there can't be more of them than symbols left
+ExitCodes readTree(InputStream* input, Node* root, Arena* arena, unsigned char* symbols, int* symbolCount) {
+    Node* stack[NUMBER_OF_CHARS];
+    int stackSize = 0;
+    stack[stackSize++] = root;
+
+    while (stackSize > 0) {
+        Node* curNode = stack[--stackSize];
+        unsigned int isCurrentNodeLeaf;
+        if (!readBits(input, 1, &isCurrentNodeLeaf)) {
+            return WRONG_INPUT;
+        }
+
+        if (isCurrentNodeLeaf) {
+            unsigned int symbol;
+            if (!readBits(input, 8, &symbol) || *symbolCount == NUMBER_OF_CHARS) {
+                return WRONG_INPUT;
+            }
+
+            curNode -> symbol = (unsigned char)symbol;
+            symbols[(*symbolCount)++] = curNode -> symbol;
+            continue;
+        }
+
+        if (*symbolCount + stackSize + 2 > NUMBER_OF_CHARS) {
+            return WRONG_INPUT;
+        }
+        curNode -> left = (Node*)arenaAlloc(arena, sizeof(Node));
+        curNode -> right = (Node*)arenaAlloc(arena, sizeof(Node));
+        if (!curNode -> left || !curNode -> right) {
+            return OUT_OF_MEMORY;
+        }
+
+        stack[stackSize++] = curNode -> right;
+        stack[stackSize++] = curNode -> left;
+    }
+
+    return SUCCESS;
+}
+
+ExitCodes unzip(InputStream* input, size_t count, const Code* codes, const unsigned char* symbols, int symbolCount,
+        Arena* arena, OutputStream* output) {
+    //The only symbol has empty code, nothing was written for it
+    if (symbolCount == 1) {
+        for (size_t i = 0; i < count; i++) {
+            writeSymbol(output, symbols[0]);
+        }
+
+        return SUCCESS;
+    }
+
+    DecodeTables tables = {arena, NULL, 0, 0};
+    int root;
+    ExitCodes curAction;
+    if ((curAction = buildDecodeTables(&tables, codes, symbols, symbolCount, &root)) != SUCCESS) {
+        return curAction;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        DecodeEntry entry;
+        if (!decodeSymbol(input, &tables, root, &entry)) {
+            return WRONG_INPUT;
+        }
+
+        writeSymbol(output, entry.symbol);
+    }
+
+    return SUCCESS;
+}
+
+//Old format: count and the whole tree
+ExitCodes decodeTreeArchive(InputStream* input, int count, Arena* arena, OutputStream* output) {
+    if (count == 0) {
+        return SUCCESS;
+    }
+
+    Node* tree = (Node*)arenaAlloc(arena, sizeof(Node));
     if (!tree) {
         return OUT_OF_MEMORY;
     }
 
-    ExitCodes curAction;
-    if ((curAction = getDecodingData(&count, tree)) != SUCCESS) {
-        return curAction;
+    Code codes[NUMBER_OF_CHARS];
+    unsigned char symbols[NUMBER_OF_CHARS];
+    int symbolCount = 0;
+
+    ExitCodes curAction;
+    if ((curAction = readTree(input, tree, arena, symbols, &symbolCount)) != SUCCESS) {
+        return curAction;
+    }
+    if (!startFilling(codes, tree)) {
+        return WRONG_INPUT;
+    }
+
+    //Tree is padded up to the whole byte, data starts from the next one
+    alignToByte(input);
+
+    return unzip(input, (size_t)count, codes, symbols, symbolCount, arena, output);
+}
+
+ExitCodes decodeBlock(InputStream* input, size_t count, Arena* arena, OutputStream* output) {
+    CodeLengths codeLengths;
+    Code codes[NUMBER_OF_CHARS];
+
+    ExitCodes curAction;
+    if ((curAction = readCodeLengths(input, &codeLengths)) != SUCCESS) {
+        return curAction;
+    }
+    if (!assignCanonicalCodes(&codeLengths, codes)) {
+        return WRONG_INPUT;
+    }
+
+    //Code lengths are padded up to the whole byte, data starts from the next one
+    alignToByte(input);
+
+    return unzip(input, count, codes, codeLengths.symbols, codeLengths.symbolCount, arena, output);
+}
+
+//Every context has its own root table, contexts with the only symbol don't need tables at all
+ExitCodes decodeContextBlock(InputStream* input, size_t count, Arena* arena, OutputStream* output) {
+    DecodeTables tables = {arena, NULL, 0, 0};
+    int roots[NUMBER_OF_CHARS];
+    int onlySymbols[NUMBER_OF_CHARS];
+
+    for (int i = 0; i < NUMBER_OF_CHARS; i++) {
+        unsigned int isUsed;
+        if (!readBits(input, 1, &isUsed)) {
+            return WRONG_INPUT;
+        }
+
+        roots[i] = onlySymbols[i] = -1;
+        if (!isUsed) {
+            continue;
+        }
+
+        //Encoder never makes longer codes, that bounds the number of tables
+        CodeLengths codeLengths;
+        Code codes[NUMBER_OF_CHARS];
+        ExitCodes curAction;
+        if ((curAction = readCodeLengths(input, &codeLengths)) != SUCCESS) {
+            return curAction;
+        }
+        if (codeLengths.maxLength > CODE_LENGTH_LIMIT || !assignCanonicalCodes(&codeLengths, codes)) {
+            return WRONG_INPUT;
+        }
+
+        if (codeLengths.symbolCount == 1) {
+            onlySymbols[i] = codeLengths.symbols[0];
+        } else if ((curAction = buildDecodeTables(&tables, codes, codeLengths.symbols, codeLengths.symbolCount,
+                &roots[i])) != SUCCESS) {
+            return curAction;
+        }
+    }
+    alignToByte(input);
+
+    int previous = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (onlySymbols[previous] >= 0) {
+            previous = onlySymbols[previous];
+            writeSymbol(output, (unsigned char)previous);
+            continue;
+        }
+        if (roots[previous] < 0) {
+            return WRONG_INPUT;
+        }
+
+        DecodeEntry entry;
+        if (!decodeSymbol(input, &tables, roots[previous], &entry)) {
+            return WRONG_INPUT;
+        }
+
+        previous = entry.symbol;
+        writeSymbol(output, entry.symbol);
+    }
+
+    return SUCCESS;
+}
+
+ExitCodes readRansModel(InputStream* input, RansModel* model, unsigned char* slots) {
+    unsigned int value;
+    if (!readBits(input, 8, &value)) {
+        return WRONG_INPUT;
+    }
+
+    int symbolCount = (int)value + 1;
+    int previous = -1;
+    unsigned int start = 0;
+    memset(model -> frequencies, 0, sizeof(model -> frequencies));
+    for (int i = 0; i < symbolCount; i++) {
+        unsigned int symbol, frequency;
+        if (!readBits(input, 8, &symbol) || (int)symbol <= previous || !readBits(input, PROB_BITS, &frequency) ||
+                start + frequency + 1 > PROB_SCALE) {
+            return WRONG_INPUT;
+        }
+
+        previous = (int)symbol;
+        model -> frequencies[symbol] = frequency + 1;
+        model -> starts[symbol] = start;
+        memset(slots + start, (int)symbol, frequency + 1);
+        start += frequency + 1;
+    }
+
+    return start == PROB_SCALE ? SUCCESS : WRONG_INPUT;
+}
+
+//Takes the symbol of the state and puts the state back into range
+int ransDecodeStep(unsigned int* state, const RansModel* model, const unsigned char* slots,
+        const unsigned char** place, const unsigned char* end, unsigned char* symbol) {
+    unsigned int slot = *state & (PROB_SCALE - 1);
+    *symbol = slots[slot];
+
+    *state = model -> frequencies[*symbol] * (*state >> PROB_BITS) + slot - model -> starts[*symbol];
+    while (*state < RANS_LOW) {
+        if (*place == end) {
+            return false;
+        }
+        *state = (*state << 8) | *(*place)++;
+    }
+
+    return true;
+}
+
+//States are renormalized from the same bytes in the same order they were written. Symbols are
+//taken from all states in turn, their chains don't wait for each other
+ExitCodes decodeRansBlock(InputStream* input, size_t count, OutputStream* output) {
+    RansModel model;
+    unsigned char slots[PROB_SCALE];
+    ExitCodes curAction;
+    if ((curAction = readRansModel(input, &model, slots)) != SUCCESS) {
+        return curAction;
+    }
+    alignToByte(input);
+
+    const unsigned char* place;
+    size_t size;
+    takeRemainingBytes(input, &place, &size);
+    const unsigned char* end = place + size;
+    if (size < 4 * RANS_STATES) {
+        return WRONG_INPUT;
+    }
+
+    unsigned int states[RANS_STATES];
+    for (int i = 0; i < RANS_STATES; i++) {
+        states[i] = 0;
+        for (int j = 0; j < 4; j++) {
+            states[i] = (states[i] << 8) | *place++;
+        }
+    }
+
+    size_t i = 0;
+    for (; i + RANS_STATES <= count; i += RANS_STATES) {
+        unsigned char symbols[RANS_STATES];
+        for (int k = 0; k < RANS_STATES; k++) {
+            if (!ransDecodeStep(&states[k], &model, slots, &place, end, &symbols[k])) {
+                return WRONG_INPUT;
+            }
+        }
+        for (int k = 0; k < RANS_STATES; k++) {
+            writeSymbol(output, symbols[k]);
+        }
+    }
+    for (int k = 0; i < count; i++, k++) {
+        unsigned char symbol;
+        if (!ransDecodeStep(&states[k], &model, slots, &place, end, &symbol)) {
+            return WRONG_INPUT;
+        }
+        writeSymbol(output, symbol);
+    }
+
+    return SUCCESS;
+}
+
+//Blocks of versions 6 and later start with their mode
+ExitCodes decodeModalBlock(InputStream* input, size_t count, Arena* arena, OutputStream* output) {
+    unsigned int mode;
+    if (!readBits(input, 8, &mode)) {
+        return WRONG_INPUT;
+    }
+
+    switch (mode) {
+        case ORDER0_MODE:
+            return decodeBlock(input, count, arena, output);
+        case ORDER1_MODE:
+            return decodeContextBlock(input, count, arena, output);
+        case RANS_MODE:
+            return decodeRansBlock(input, count, output);
+        default:
+            return WRONG_INPUT;
+    }
+}
+
+/////Checksum
+//Adler-32 of the raw block: it is cheap enough to be counted on every block and is stored
+//as four bytes, the lowest first
+
+#define ADLER_MODULO 65521
+//Sums don't overflow 32 bits in that many steps
+#define ADLER_STEP 5552
+
+unsigned int getChecksum(const unsigned char* data, size_t size) {
+    unsigned int first = 1, second = 0;
+
+    while (size > 0) {
+        size_t part = size < ADLER_STEP ? size : ADLER_STEP;
+        for (size_t i = 0; i < part; i++) {
+            first += data[i];
+            second += first;
+        }
+
+        first %= ADLER_MODULO;
+        second %= ADLER_MODULO;
+        data += part;
+        size -= part;
+    }
+
+    return (second << 16) | first;
+}
+
+void writeChecksum(OutputStream* outputStream, unsigned int checksum) {
+    for (int i = 0; i < 4; i++) {
+        writeSymbol(outputStream, (unsigned char)(checksum >> (8 * i)));
+    }
+}
+
+int readChecksum(ByteSource* source, unsigned int* checksum) {
+    unsigned char bytes[4];
+    if (readBytes(source, bytes, 4) < 4) {
+        return false;
+    }
+
+    *checksum = 0;
+    for (int i = 0; i < 4; i++) {
+        *checksum |= (unsigned int)bytes[i] << (8 * i);
+    }
+
+    return true;
+}
+
+//////////////
+
+/////Block container
+//Input is cut into blocks of BLOCK_SIZE bytes, every block has its own code lengths and is coded
+//independently on the thread pool. Archive is the signature, total length, block size and
+//the index of compressed block sizes with checksums, blocks follow it. Whole input is kept in
+//memory, so only inputs up to INDEXED_SIZE_LIMIT are written this way
+
+#define BLOCK_SIZE (1 << 20)
+#define MAX_BLOCK_SIZE (1 << 30)
+#define INDEXED_SIZE_LIMIT (256 << 20)
+
+typedef struct _block Block;
+typedef struct _block_list BlockList;
+
+struct _block {
+    const unsigned char* data;
+    size_t size;
+    size_t rawSize;
+    size_t headerSize;
+    unsigned int checksum;
+    OutputStream* output;
+    unsigned char* buffer;
+    size_t bufferCapacity;
+    Arena arena;
+};
+
+struct _block_list {
+    Block* blocks;
+    int count;
+    EncoderOptions options;
+    int hasChecksums;
+    int hasModes;
+};
+
+BlockList* allocBlockList(int count) {
+    BlockList* list = (BlockList*)calloc(1, sizeof(BlockList));
+    if (!list) {
+        return NULL;
+    }
+    list -> blocks = (Block*)calloc((size_t)count + 1, sizeof(Block));
+    if (!list -> blocks) {
+        free(list);
+        return NULL;
+    }
+    list -> count = count;
+
+    return list;
+}
+
+void freeBlockList(BlockList* list) {
+    for (int i = 0; i < list -> count; i++) {
+        if (list -> blocks[i].output) {
+            freeOutputStream(list -> blocks[i].output);
+        }
+        free(list -> blocks[i].buffer);
+        freeArena(&list -> blocks[i].arena);
+    }
+
+    free(list -> blocks);
+    free(list);
+}
+
+//Block of a stream is read to its own buffer, which is kept for the next batch
+int reserveBlockBuffer(Block* block, size_t size) {
+    if (size <= block -> bufferCapacity) {
+        return true;
+    }
+
+    unsigned char* buffer = (unsigned char*)realloc(block -> buffer, size);
+    if (!buffer) {
+        return false;
+    }
+    block -> buffer = buffer;
+    block -> bufferCapacity = size;
+
+    return true;
+}
+
+//Output of the previous batch is reused when there is one
+int prepareBlockOutput(Block* block, size_t capacity) {
+    if (block -> output) {
+        resetOutputStream(block -> output);
+        return true;
+    }
+
+    block -> output = allocOutputStream(NULL, capacity);
+    return block -> output != NULL;
+}
+
+ExitCodes encodeBlockJob(void* context, int index) {
+    BlockList* list = (BlockList*)context;
+    Block* block = &list -> blocks[index];
+
+    //Huffman code is never longer than source, a quarter is a good first guess
+    if (!prepareBlockOutput(block, block -> rawSize / 4 + NUMBER_OF_CHARS)) {
+        return OUT_OF_MEMORY;
+    }
+
+    block -> checksum = getChecksum(block -> data, block -> rawSize);
+
+    resetArena(&block -> arena);
+    return encodeBlock(block -> data, block -> rawSize, &list -> options, &block -> arena, block -> output,
+            &block -> headerSize);
+}
+
+ExitCodes decodeBlockJob(void* context, int index) {
+    BlockList* list = (BlockList*)context;
+    Block* block = &list -> blocks[index];
+
+    if (!prepareBlockOutput(block, block -> rawSize)) {
+        return OUT_OF_MEMORY;
+    }
+
+    ByteSource source;
+    initMemorySource(&source, block -> data, block -> size);
+    InputStream input = {&source, 0, 0};
+
+    resetArena(&block -> arena);
+    ExitCodes curAction;
+    if (list -> hasModes) {
+        curAction = decodeModalBlock(&input, block -> rawSize, &block -> arena, block -> output);
+    } else {
+        curAction = decodeBlock(&input, block -> rawSize, &block -> arena, block -> output);
+    }
+    if (curAction != SUCCESS) {
+        return curAction;
+    }
+
+    if (list -> hasChecksums && getChecksum(block -> output -> buffer, block -> output -> curSize) != block -> checksum) {
+        return CHECKSUM_MISMATCH;
+    }
+
+    return SUCCESS;
+}
+
+ExitCodes writeBlocks(const BlockList* list, int count, OutputStream* output) {
+    for (int i = 0; i < count; i++) {
+        if (!appendOutputStream(output, list -> blocks[i].output)) {
+            return getOutputError(output);
+        }
+    }
+
+    return SUCCESS;
+}
+
+//headerSize is set to the number of bytes which are not the coded data
+ExitCodes encodeSource(ByteSource* source, const EncoderOptions* options, ThreadPool* pool, OutputStream* output,
+        size_t* headerSize) {
+    if (!loadWholeSource(source)) {
+        return OUT_OF_MEMORY;
+    }
+
+    const unsigned char* data = source -> data + source -> position;
+    size_t size = source -> size - source -> position;
+    int blockCount = (int)((size + BLOCK_SIZE - 1) / BLOCK_SIZE);
+
+    BlockList* list = allocBlockList(blockCount);
+    if (!list) {
+        return OUT_OF_MEMORY;
+    }
+    list -> options = *options;
+    for (int i = 0; i < blockCount; i++) {
+        size_t offset = (size_t)i * BLOCK_SIZE;
+        list -> blocks[i].data = data + offset;
+        list -> blocks[i].rawSize = size - offset < BLOCK_SIZE ? size - offset : BLOCK_SIZE;
+    }
+
+    ExitCodes result = runInPool(pool, encodeBlockJob, list, blockCount);
+    if (result == SUCCESS) {
+        writeRawBytes(output, SIGNATURE, SIGNATURE_SIZE - 1);
+        writeSymbol(output, 0x80 | MODAL_BLOCKS_VERSION);
+        writeNumber(output, size);
+        writeNumber(output, BLOCK_SIZE);
+        *headerSize = SIGNATURE_SIZE + getNumberSize(size) + getNumberSize(BLOCK_SIZE);
+        for (int i = 0; i < blockCount; i++) {
+            writeNumber(output, list -> blocks[i].output -> curSize);
+            writeChecksum(output, list -> blocks[i].checksum);
+            *headerSize += getNumberSize(list -> blocks[i].output -> curSize) + 4 + list -> blocks[i].headerSize;
+        }
+
+        result = writeBlocks(list, list -> count, output);
+    }
+
+    freeBlockList(list);
+    return result;
+}
+
+//Versions after 2 add checksums and then modes
+ExitCodes decodeBlockArchive(ByteSource* source, ThreadPool* pool, int version, OutputStream* output) {
+    int hasChecksums = version >= CHECKED_BLOCKS_VERSION;
+
+    unsigned long long total, blockSize;
+    if (!readNumber(source, &total) || !readNumber(source, &blockSize) || blockSize == 0 ||
+            blockSize > MAX_BLOCK_SIZE) {
+        return WRONG_INPUT;
+    }
+    if (!loadWholeSource(source)) {
+        return OUT_OF_MEMORY;
+    }
+
+    //Every block takes at least a byte in the index, that bounds their number before allocation
+    unsigned long long blockCount = total / blockSize + (total % blockSize != 0);
+    if (blockCount > source -> size - source -> position || blockCount > INT_MAX) {
+        return WRONG_INPUT;
+    }
+
+    BlockList* list = allocBlockList((int)blockCount);
+    if (!list) {
+        return OUT_OF_MEMORY;
+    }
+    list -> hasChecksums = hasChecksums;
+    list -> hasModes = version >= MODAL_BLOCKS_VERSION;
+
+    ExitCodes result = SUCCESS;
+    for (int i = 0; i < list -> count; i++) {
+        unsigned long long size;
+        if (!readNumber(source, &size) || (hasChecksums && !readChecksum(source, &list -> blocks[i].checksum))) {
+            result = WRONG_INPUT;
+            break;
+        }
+
+        unsigned long long rest = total - (unsigned long long)i * blockSize;
+        list -> blocks[i].size = (size_t)size;
+        list -> blocks[i].rawSize = (size_t)(rest < blockSize ? rest : blockSize);
+    }
+
+    for (int i = 0; i < list -> count && result == SUCCESS; i++) {
+        if (list -> blocks[i].size > source -> size - source -> position) {
+            result = WRONG_INPUT;
+            break;
+        }
+
+        list -> blocks[i].data = source -> data + source -> position;
+        source -> position += list -> blocks[i].size;
+    }
+
+    if (result == SUCCESS) {
+        result = runInPool(pool, decodeBlockJob, list, list -> count);
+    }
+    if (result == SUCCESS) {
+        result = writeBlocks(list, list -> count, output);
+    }
+
+    freeBlockList(list);
+    return result;
+}
+
+/////Streaming
+//Pipes can't be read twice and may be endless, so the archive is a sequence of frames: raw size,
+//compressed size, checksum and the block. Only a batch of blocks is kept in memory, it is coded on the pool
+//and written out before the next one is read. Frame with zero raw size ends the archive
+
+#define BLOCKS_PER_THREAD 2
+
+//Code can't be longer than MAX_CODE_LENGTH bits, code lengths take less than two bytes per symbol
+size_t maxPackedSize(size_t rawSize) {
+    return rawSize / 8 * MAX_CODE_LENGTH + MAX_CODE_LENGTH + 2 * NUMBER_OF_CHARS;
+}
+
+BlockList* allocBatch(ThreadPool* pool, const EncoderOptions* options) {
+    BlockList* list = allocBlockList((pool -> threadCount + 1) * BLOCKS_PER_THREAD);
+    if (list && options) {
+        list -> options = *options;
+    }
+
+    return list;
+}
+
+ExitCodes writeFrames(const BlockList* list, int count, OutputStream* output, size_t* headerSize) {
+    for (int i = 0; i < count; i++) {
+        writeNumber(output, list -> blocks[i].rawSize);
+        writeNumber(output, list -> blocks[i].output -> curSize);
+        writeChecksum(output, list -> blocks[i].checksum);
+        *headerSize += getNumberSize(list -> blocks[i].rawSize) + getNumberSize(list -> blocks[i].output -> curSize) +
+                4 + list -> blocks[i].headerSize;
+        if (!appendOutputStream(output, list -> blocks[i].output)) {
+            return getOutputError(output);
+        }
+    }
+
+    //Reader on the other side of the pipe gets every batch as soon as it is ready
+    return emitOutputStream(output) ? SUCCESS : getOutputError(output);
+}
+
+ExitCodes encodeStream(ByteSource* source, const EncoderOptions* options, ThreadPool* pool, OutputStream* output,
+        size_t* headerSize) {
+    BlockList* list = allocBatch(pool, options);
+    if (!list) {
+        return OUT_OF_MEMORY;
+    }
+
+    writeRawBytes(output, SIGNATURE, SIGNATURE_SIZE - 1);
+    writeSymbol(output, 0x80 | MODAL_STREAM_VERSION);
+    writeNumber(output, BLOCK_SIZE);
+    //One more byte is the end of the stream
+    *headerSize = SIGNATURE_SIZE + getNumberSize(BLOCK_SIZE) + 1;
+
+    ExitCodes result = SUCCESS;
+    int isEnd = false;
+    while (!isEnd && result == SUCCESS) {
+        int count = 0;
+        while (count < list -> count && !isEnd) {
+            Block* block = &list -> blocks[count];
+            if (!reserveBlockBuffer(block, BLOCK_SIZE)) {
+                result = OUT_OF_MEMORY;
+                break;
+            }
+
+            block -> rawSize = takeBytes(source, BLOCK_SIZE, block -> buffer, &block -> data);
+            isEnd = block -> rawSize < BLOCK_SIZE;
+            if (block -> rawSize > 0) {
+                count++;
+            }
+        }
+
+        if (result == SUCCESS) {
+            result = runInPool(pool, encodeBlockJob, list, count);
+        }
+        if (result == SUCCESS) {
+            result = writeFrames(list, count, output, headerSize);
+        }
+    }
+    writeNumber(output, 0);
+
+    freeBlockList(list);
+    return result;
+}
+
+ExitCodes decodeStream(ByteSource* source, ThreadPool* pool, int version, OutputStream* output) {
+    int hasChecksums = version >= CHECKED_STREAM_VERSION;
+
+    unsigned long long blockSize;
+    if (!readNumber(source, &blockSize) || blockSize == 0 || blockSize > MAX_BLOCK_SIZE) {
+        return WRONG_INPUT;
+    }
+
+    BlockList* list = allocBatch(pool, NULL);
+    if (!list) {
+        return OUT_OF_MEMORY;
+    }
+    list -> hasChecksums = hasChecksums;
+    list -> hasModes = version >= MODAL_STREAM_VERSION;
+
+    ExitCodes result = SUCCESS;
+    int isEnd = false;
+    while (!isEnd && result == SUCCESS) {
+        int count = 0;
+        while (count < list -> count) {
+            unsigned long long rawSize, size;
+            if (!readNumber(source, &rawSize)) {
+                result = WRONG_INPUT;
+                break;
+            }
+            if (rawSize == 0) {
+                isEnd = true;
+                break;
+            }
+            Block* block = &list -> blocks[count];
+            if (rawSize > blockSize || !readNumber(source, &size) || size > maxPackedSize((size_t)rawSize) ||
+                    (hasChecksums && !readChecksum(source, &block -> checksum))) {
+                result = WRONG_INPUT;
+                break;
+            }
+
+            if (!reserveBlockBuffer(block, (size_t)size)) {
+                result = OUT_OF_MEMORY;
+                break;
+            }
+
+            block -> rawSize = (size_t)rawSize;
+            block -> size = takeBytes(source, (size_t)size, block -> buffer, &block -> data);
+            if (block -> size < size) {
+                result = WRONG_INPUT;
+                break;
+            }
+            count++;
+        }
+
+        if (result == SUCCESS) {
+            result = runInPool(pool, decodeBlockJob, list, count);
+        }
+        if (result == SUCCESS) {
+            result = writeBlocks(list, count, output);
+        }
+        if (result == SUCCESS && !emitOutputStream(output)) {
+            result = getOutputError(output);
+        }
     }
 
-    if (count == 0) {
+    freeBlockList(list);
+    return result;
+}
+
+//////////////////
+
+//Archive starts with the signature whose last byte is the version, or it is of the old format:
+//count and the whole tree
+//Arena is used for single-block archives, blocks of the others have their own
+ExitCodes decodeSource(ByteSource* source, ThreadPool* pool, Arena* arena, OutputStream* output) {
+    unsigned char head[SIGNATURE_SIZE];
+    size_t headSize = readBytes(source, head, SIGNATURE_SIZE);
+    if (headSize == 0) {
         return SUCCESS;
     }
+    if (headSize < SIGNATURE_SIZE) {
+        return WRONG_INPUT;
+    }
 
-    //So we can start decoding
-    if ((curAction = unzip(count, tree)) != SUCCESS) {
-        return curAction;
+    InputStream input = {source, 0, 0};
+    if (!(head[SIGNATURE_SIZE - 1] & 0x80)) {
+        int count;
+        memcpy(&count, head, sizeof(int));
+
+        return decodeTreeArchive(&input, count, arena, output);
+    }
+
+    if (memcmp(head, SIGNATURE, SIGNATURE_SIZE - 1) != 0) {
+        return WRONG_INPUT;
+    }
+
+    unsigned long long count;
+    int version = head[SIGNATURE_SIZE - 1] & 0x7F;
+    switch (version) {
+        case SINGLE_BLOCK_VERSION:
+            if (!readNumber(source, &count)) {
+                return WRONG_INPUT;
+            }
+
+            return count ? decodeBlock(&input, (size_t)count, arena, output) : SUCCESS;
+        case BLOCKS_VERSION:
+        case CHECKED_BLOCKS_VERSION:
+        case MODAL_BLOCKS_VERSION:
+            return decodeBlockArchive(source, pool, version, output);
+        case STREAM_VERSION:
+        case CHECKED_STREAM_VERSION:
+        case MODAL_STREAM_VERSION:
+            return decodeStream(source, pool, version, output);
+        default:
+            return WRONG_INPUT;
+    }
+}
+
+//////////////////
+
+/////Library interface
+//Context keeps the thread pool and the memory of single-block archives, nothing is global.
+//Different contexts may be used from different threads at the same time, one context serves
+//one call at a time. Compile with HUFFMAN_LIBRARY defined to leave out main()
+
+typedef struct _huffman_context HuffmanContext;
+
+struct _huffman_context {
+    ThreadPool* pool;
+    Arena arena;
+    EncoderOptions options;
+    size_t headerSize;
+};
+
+//Zero or less threads means one per processor
+HuffmanContext* createHuffmanContext(int threadCount) {
+    HuffmanContext* context = (HuffmanContext*)calloc(1, sizeof(HuffmanContext));
+    if (!context) {
+        return NULL;
+    }
+
+    context -> pool = createThreadPool(threadCount > 0 ? threadCount : getProcessorCount());
+    if (!context -> pool) {
+        free(context);
+        return NULL;
+    }
+    context -> options = (EncoderOptions){CODE_LENGTH_LIMIT, false, false};
+
+    return context;
+}
+
+void freeHuffmanContext(HuffmanContext* context) {
+    destroyThreadPool(context -> pool);
+    freeArena(&context -> arena);
+    free(context);
+}
+
+//With order-1 contexts every block is coded by tables of the previous byte when that's shorter;
+//it's slower to compress, decompression speed stays about the same
+void setContextModeling(HuffmanContext* context, int useContexts) {
+    context -> options.useContexts = useContexts;
+}
+
+//With rANS every block is coded by asymmetric numeral systems when that's shorter: skewed data loses
+//less than a bit per symbol then. Decoding is a bit slower than the one of Huffman codes
+void setRansCoding(HuffmanContext* context, int useRans) {
+    context -> options.useRans = useRans;
+}
+
+const char* getHuffmanMessage(ExitCodes exitCode) {
+    return exitMessages[exitCode];
+}
+
+//Bytes of the last archive made by the context which are not the coded data:
+//signature, sizes of blocks and their code lengths
+size_t getHeaderSize(const HuffmanContext* context) {
+    return context -> headerSize;
+}
+
+//Size of the biggest archive compressBuffer() can make of size bytes. Frequencies of rANS take
+//less than three bytes per symbol, its symbol is never longer than a Huffman code
+size_t getCompressBound(size_t size) {
+    size_t blockCount = size / BLOCK_SIZE + 1;
+
+    return SIGNATURE_SIZE + 30 + blockCount * (20 + 3 * NUMBER_OF_CHARS) + size / 8 * CODE_LENGTH_LIMIT +
+            CODE_LENGTH_LIMIT;
+}
+
+ExitCodes compressSource(HuffmanContext* context, ByteSource* source, OutputStream* output) {
+    //Only input in memory is known as a whole in advance, anything else is coded on the fly
+    ExitCodes result;
+    if (source -> kind != STREAM_SOURCE && source -> size - source -> position <= INDEXED_SIZE_LIMIT) {
+        result = encodeSource(source, &context -> options, context -> pool, output, &context -> headerSize);
+    } else {
+        result = encodeStream(source, &context -> options, context -> pool, output, &context -> headerSize);
+    }
+
+    if (!emitOutputStream(output) && result == SUCCESS) {
+        result = getOutputError(output);
+    }
+
+    return result;
+}
+
+ExitCodes decompressSource(HuffmanContext* context, ByteSource* source, OutputStream* output) {
+    ExitCodes result = decodeSource(source, context -> pool, &context -> arena, output);
+    resetArena(&context -> arena);
+
+    if (!emitOutputStream(output) && result == SUCCESS) {
+        result = getOutputError(output);
+    }
+
+    return result;
+}
+
+typedef ExitCodes (*SourceAction)(HuffmanContext* context, ByteSource* source, OutputStream* output);
+
+//Input is taken from the current position of the file
+ExitCodes runOnFiles(HuffmanContext* context, SourceAction action, FILE* fileIn, FILE* fileOut) {
+    ByteSource* source = openByteSource(fileIn);
+    if (!source) {
+        return OUT_OF_MEMORY;
+    }
+
+    ExitCodes result = OUT_OF_MEMORY;
+    OutputStream* output = allocOutputStream(fileOut, OUTPUT_BUFFER_SIZE);
+    if (output) {
+        result = action(context, source, output);
+        freeOutputStream(output);
+    }
+    closeByteSource(source);
+
+    return result;
+}
+
+ExitCodes runOnBuffers(HuffmanContext* context, SourceAction action, const unsigned char* source, size_t size,
+        unsigned char* destination, size_t capacity, size_t* written) {
+    ByteSource input;
+    initMemorySource(&input, source, size);
+
+    OutputStream output;
+    initBufferOutputStream(&output, destination, capacity);
+
+    ExitCodes result = action(context, &input, &output);
+    *written = result == SUCCESS ? output.curSize : 0;
+
+    return result;
+}
+
+ExitCodes compressStream(HuffmanContext* context, FILE* fileIn, FILE* fileOut) {
+    return runOnFiles(context, compressSource, fileIn, fileOut);
+}
+
+ExitCodes decompressStream(HuffmanContext* context, FILE* fileIn, FILE* fileOut) {
+    return runOnFiles(context, decompressSource, fileIn, fileOut);
+}
+
+//Destination of getCompressBound(size) bytes is always enough
+ExitCodes compressBuffer(HuffmanContext* context, const unsigned char* source, size_t size,
+        unsigned char* destination, size_t capacity, size_t* written) {
+    return runOnBuffers(context, compressSource, source, size, destination, capacity, written);
+}
+
+ExitCodes decompressBuffer(HuffmanContext* context, const unsigned char* source, size_t size,
+        unsigned char* destination, size_t capacity, size_t* written) {
+    return runOnBuffers(context, decompressSource, source, size, destination, capacity, written);
+}
+
+//////////////////////
+
+#ifndef HUFFMAN_LIBRARY
+
+FILE* fileIn;
+FILE* fileOut;
+
+/////Starting methods
+void getMessage(ExitCodes exitCode) {
+    fprintf(fileOut,"%s", getHuffmanMessage(exitCode));
+}
+
+int correctOption(unsigned char* option) {
+    if (fread(option, sizeof(unsigned char), 2, fileIn) < 2 || option[1] != '\n') {
+        return false;
+    }
+
+    return true;
+}
+
+/////////////////////
+
+ExitCodes encoding(int useContexts, int useRans) {
+    HuffmanContext* context = createHuffmanContext(0);
+    if (!context) {
+        return OUT_OF_MEMORY;
+    }
+    setContextModeling(context, useContexts);
+    setRansCoding(context, useRans);
+
+    //Option is followed by the line break, data starts after it
+    fgetc(fileIn);
+
+    ExitCodes result = compressStream(context, fileIn, fileOut);
+    freeHuffmanContext(context);
+
+    return result;
+}
+
+ExitCodes decoding() {
+    HuffmanContext* context = createHuffmanContext(0);
+    if (!context) {
+        return OUT_OF_MEMORY;
+    }
+
+    ExitCodes result = decompressStream(context, fileIn, fileOut);
+    freeHuffmanContext(context);
+
+    return result;
+}
+
+/////Benchmark
+//Every corpus is coded by every coder. Every case is run in its own process, so its peak RSS isn't mixed with the others. Results are
+//printed as tab-separated lines to be diffed between builds. Sizes in bytes may follow the option
+//("b 1024 4294967296"), otherwise the default ones are taken
+
+#define BENCHMARK_RUNS 3
+#define BENCHMARK_REPEAT_LIMIT (64 << 20)
+#define BENCHMARK_CHUNK_SIZE (1 << 20)
+#define MAX_BENCHMARK_SIZES 16
+
+typedef void (*CorpusFiller)(unsigned char* chunk, size_t size, unsigned int* seed);
+typedef struct _corpus Corpus;
+typedef struct _coder Coder;
+typedef struct _benchmark_result BenchmarkResult;
+
+//Order-1 coding has to be smaller than order-0 on a corpus with contexts, otherwise the benchmark fails
+struct _corpus {
+    const char* name;
+    CorpusFiller fill;
+    int hasContexts;
+};
+
+struct _coder {
+    const char* name;
+    int useContexts;
+    int useRans;
+};
+
+struct _benchmark_result {
+    ExitCodes result;
+    unsigned long long compressedSize;
+    unsigned long long headerSize;
+    double encodeTime;
+    double decodeTime;
+};
+
+double getTime() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+
+unsigned int nextRandom(unsigned int* seed) {
+    *seed = *seed * 1103515245 + 12345;
+
+    return *seed >> 16;
+}
+
+void fillUniform(unsigned char* chunk, size_t size, unsigned int* seed) {
+    for (size_t i = 0; i < size; i++) {
+        chunk[i] = (unsigned char)nextRandom(seed);
+    }
+}
+
+//Probability of the k-th symbol is proportional to 1 / (k + 1)
+void fillZipf(unsigned char* chunk, size_t size, unsigned int* seed) {
+    double total = 0;
+    for (int i = 0; i < NUMBER_OF_CHARS; i++) {
+        total += 1.0 / (i + 1);
+    }
+
+    unsigned int bounds[NUMBER_OF_CHARS];
+    double sum = 0;
+    for (int i = 0; i < NUMBER_OF_CHARS; i++) {
+        sum += 1.0 / (i + 1);
+        bounds[i] = (unsigned int)(sum / total * 65536);
+    }
+    bounds[NUMBER_OF_CHARS - 1] = 65536;
+
+    for (size_t i = 0; i < size; i++) {
+        unsigned int value = nextRandom(seed) & 0xFFFF;
+        int left = 0, right = NUMBER_OF_CHARS - 1;
+        while (left < right) {
+            int middle = (left + right) / 2;
+            if (value < bounds[middle]) {
+                right = middle;
+            } else {
+                left = middle + 1;
+            }
+        }
+
+        chunk[i] = (unsigned char)left;
+    }
+}
+
+//Letters are taken with skewed probabilities, so codes have different lengths
+void fillText(unsigned char* chunk, size_t size, unsigned int* seed) {
+    const char* alphabet = "eeeeeeeeetttttaaaaooooiiinnnsssrrhhlldcumfpgwybvkxjqz     ,.\n";
+    unsigned int alphabetLength = (unsigned int)strlen(alphabet);
+
+    for (size_t i = 0; i < size; i++) {
+        chunk[i] = (unsigned char)alphabet[nextRandom(seed) % alphabetLength];
+    }
+}
+
+//Mostly zeros with rare small values like in telemetry, the best symbol is much cheaper than a bit
+void fillSkewed(unsigned char* chunk, size_t size, unsigned int* seed) {
+    for (size_t i = 0; i < size; i++) {
+        unsigned int value = nextRandom(seed);
+        chunk[i] = (value & 0xF) ? 0 : (unsigned char)(1 + (value >> 4) % 7);
+    }
+}
+
+//Counts of symbols are Fibonacci numbers, so the Huffman tree is a chain as deep as it can be
+//and codes hit the length limit
+void fillFibonacci(unsigned char* chunk, size_t size, unsigned int* seed) {
+    size_t filled = 0;
+    size_t previous = 0, current = 1;
+    for (int symbol = 0; filled < size; symbol = (symbol + 1) % NUMBER_OF_CHARS) {
+        size_t part = current < size - filled ? current : size - filled;
+        memset(chunk + filled, symbol, part);
+        filled += part;
+
+        size_t next = previous + current;
+        previous = current;
+        current = next;
+    }
+
+    //Symbols are mixed up, so there are no long runs
+    for (size_t i = size; i > 1; i--) {
+        size_t j = ((size_t)nextRandom(seed) << 15 ^ nextRandom(seed)) % i;
+        unsigned char symbol = chunk[i - 1];
+        chunk[i - 1] = chunk[j];
+        chunk[j] = symbol;
+    }
+}
+
+//Lines of a service log: every byte depends on the one before it much more than on its own
+//frequency, so order-1 coding wins over order-0. A line cut at the end of a chunk goes on as a new one
+void fillLogs(unsigned char* chunk, size_t size, unsigned int* seed) {
+    static const char* levels[] = {"INFO ", "INFO ", "INFO ", "DEBUG", "WARN ", "ERROR"};
+    static const char* services[] = {"auth", "billing", "gateway", "storage", "scheduler"};
+    static const char* messages[] = {
+            "request GET /api/v1/users/%u done in %u ms",
+            "request POST /api/v1/orders/%u done in %u ms",
+            "cache miss for key session:%u, loaded in %u ms",
+            "connection %u closed by peer after %u ms",
+            "retrying job %u, attempt %u"
+    };
+    char line[160];
+
+    size_t filled = 0;
+    while (filled < size) {
+        unsigned int time = nextRandom(seed);
+        int length = snprintf(line, sizeof(line), "2026-10-17 %02u:%02u:%02u.%03u %s [%s] ", time % 24,
+                nextRandom(seed) % 60, nextRandom(seed) % 60, nextRandom(seed) % 1000,
+                levels[nextRandom(seed) % (sizeof(levels) / sizeof(levels[0]))],
+                services[nextRandom(seed) % (sizeof(services) / sizeof(services[0]))]);
+        unsigned int message = nextRandom(seed) % (sizeof(messages) / sizeof(messages[0]));
+        unsigned int first = nextRandom(seed) % 100000;
+        length += snprintf(line + length, sizeof(line) - (size_t)length, messages[message], first,
+                nextRandom(seed) % 2000);
+        line[length++] = '\n';
+
+        size_t part = (size_t)length < size - filled ? (size_t)length : size - filled;
+        memcpy(chunk + filled, line, part);
+        filled += part;
+    }
+}
+
+void fillSingle(unsigned char* chunk, size_t size, unsigned int* seed) {
+    (void)seed;
+    memset(chunk, 'a', size);
+}
+
+//Corpus without filler is always empty
+const Corpus CORPORA[] = {
+        {"uniform", fillUniform, false},
+        {"zipf", fillZipf, false},
+        {"text", fillText, false},
+        {"skewed", fillSkewed, false},
+        {"fibonacci", fillFibonacci, false},
+        {"logs", fillLogs, true},
+        {"single", fillSingle, false},
+        {"empty", NULL, false}
+};
+
+#define CORPUS_COUNT (int)(sizeof(CORPORA) / sizeof(Corpus))
+
+const Coder CODERS[] = {
+        {"huffman", false, false},
+        {"order1", true, false},
+        {"rans", false, true}
+};
+
+#define CODER_COUNT (int)(sizeof(CODERS) / sizeof(Coder))
+
+int writeCorpus(FILE* file, const Corpus* corpus, unsigned long long size) {
+    unsigned char* chunk = (unsigned char*)malloc(BENCHMARK_CHUNK_SIZE);
+    if (!chunk) {
+        return false;
+    }
+
+    unsigned int seed = 12345;
+    int isWritten = true;
+    while (size > 0 && isWritten) {
+        size_t part = size < BENCHMARK_CHUNK_SIZE ? (size_t)size : BENCHMARK_CHUNK_SIZE;
+        corpus -> fill(chunk, part, &seed);
+        isWritten = fwrite(chunk, sizeof(unsigned char), part, file) == part;
+        size -= part;
+    }
+    free(chunk);
+
+    return isWritten && fflush(file) == 0;
+}
+
+int haveSameContent(FILE* first, FILE* second) {
+    unsigned char* chunks = (unsigned char*)malloc(2 * BENCHMARK_CHUNK_SIZE);
+    if (!chunks) {
+        return false;
+    }
+
+    rewind(first);
+    rewind(second);
+    int isSame = true;
+    size_t part;
+    do {
+        part = fread(chunks, sizeof(unsigned char), BENCHMARK_CHUNK_SIZE, first);
+        size_t otherPart = fread(chunks + BENCHMARK_CHUNK_SIZE, sizeof(unsigned char), BENCHMARK_CHUNK_SIZE, second);
+        isSame = part == otherPart && memcmp(chunks, chunks + BENCHMARK_CHUNK_SIZE, part) == 0;
+    } while (isSame && part > 0);
+    free(chunks);
+
+    return isSame;
+}
+
+//File is cleared before every run, time includes flushing of the output
+ExitCodes measureRuns(HuffmanContext* context, ExitCodes (*action)(HuffmanContext*, FILE*, FILE*), FILE* input,
+        FILE* output, int runs, double* best) {
+    for (int i = 0; i < runs; i++) {
+        rewind(input);
+        rewind(output);
+        if (ftruncate(fileno(output), 0) != 0) {
+            return FILE_ERROR;
+        }
+
+        double begin = getTime();
+        ExitCodes curAction = action(context, input, output);
+        if (curAction != SUCCESS) {
+            return curAction;
+        }
+        if (fflush(output) != 0) {
+            return FILE_ERROR;
+        }
+        double elapsed = getTime() - begin;
+
+        if (i == 0 || elapsed < *best) {
+            *best = elapsed;
+        }
+    }
+
+    return SUCCESS;
+}
+
+BenchmarkResult runBenchmarkCase(const Corpus* corpus, const Coder* coder, unsigned long long size) {
+    BenchmarkResult result = {SUCCESS, 0, 0, 0, 0};
+    FILE* input = tmpfile();
+    FILE* archive = tmpfile();
+    FILE* restored = tmpfile();
+    HuffmanContext* context = createHuffmanContext(0);
+
+    if (!input || !archive || !restored) {
+        result.result = FILE_ERROR;
+    } else if (!context) {
+        result.result = OUT_OF_MEMORY;
+    } else if (!writeCorpus(input, corpus, size)) {
+        result.result = FILE_ERROR;
+    } else {
+        setContextModeling(context, coder -> useContexts);
+        setRansCoding(context, coder -> useRans);
+    }
+
+    int runs = size <= BENCHMARK_REPEAT_LIMIT ? BENCHMARK_RUNS : 1;
+    if (result.result == SUCCESS) {
+        result.result = measureRuns(context, compressStream, input, archive, runs, &result.encodeTime);
+        result.compressedSize = (unsigned long long)ftell(archive);
+        result.headerSize = getHeaderSize(context);
+    }
+    if (result.result == SUCCESS) {
+        result.result = measureRuns(context, decompressStream, archive, restored, runs, &result.decodeTime);
+    }
+    if (result.result == SUCCESS && !haveSameContent(input, restored)) {
+        result.result = WRONG_INPUT;
+    }
+
+    if (context) {
+        freeHuffmanContext(context);
+    }
+    if (input) {
+        fclose(input);
+    }
+    if (archive) {
+        fclose(archive);
+    }
+    if (restored) {
+        fclose(restored);
+    }
+
+    return result;
+}
+
+ExitCodes runIsolated(const Corpus* corpus, const Coder* coder, unsigned long long size, BenchmarkResult* result,
+        long* peakMemory) {
+    int channel[2];
+    if (pipe(channel) != 0) {
+        return FILE_ERROR;
+    }
+
+    fflush(fileOut);
+    pid_t child = fork();
+    if (child < 0) {
+        close(channel[0]);
+        close(channel[1]);
+        return FILE_ERROR;
+    }
+    if (child == 0) {
+        close(channel[0]);
+        BenchmarkResult childResult = runBenchmarkCase(corpus, coder, size);
+        ssize_t written = write(channel[1], &childResult, sizeof(BenchmarkResult));
+        _exit(written == (ssize_t)sizeof(BenchmarkResult) ? 0 : 1);
+    }
+
+    close(channel[1]);
+    ssize_t got = read(channel[0], result, sizeof(BenchmarkResult));
+    close(channel[0]);
+
+    int status;
+    struct rusage usage;
+    if (wait4(child, &status, 0, &usage) < 0 || got != (ssize_t)sizeof(BenchmarkResult)) {
+        return FILE_ERROR;
+    }
+    *peakMemory = usage.ru_maxrss;
+
+    return result -> result;
+}
+
+double getSpeed(unsigned long long size, double time) {
+    return time > 0 ? (double)size / time / (1 << 20) : 0;
+}
+
+ExitCodes benchmark() {
+    unsigned long long sizes[MAX_BENCHMARK_SIZES] = {1 << 10, 1 << 20, 64 << 20};
+    int sizeCount = 0;
+    while (sizeCount < MAX_BENCHMARK_SIZES && fscanf(fileIn, "%llu", &sizes[sizeCount]) == 1) {
+        sizeCount++;
+    }
+    if (sizeCount == 0) {
+        sizeCount = 3;
+    }
+
+    fprintf(fileOut, "corpus\tcoder\tsize\tcompressed\theader\tratio\tencode_mb_s\tdecode_mb_s\tpeak_rss_kb\n");
+    for (int i = 0; i < CORPUS_COUNT; i++) {
+        const Corpus* corpus = &CORPORA[i];
+
+        for (int j = 0; j < (corpus -> fill ? sizeCount : 1); j++) {
+            unsigned long long size = corpus -> fill ? sizes[j] : 0;
+
+            unsigned long long order0Size = 0;
+            for (int k = 0; k < CODER_COUNT; k++) {
+                BenchmarkResult result;
+                long peakMemory;
+
+                ExitCodes curAction;
+                if ((curAction = runIsolated(corpus, &CODERS[k], size, &result, &peakMemory)) != SUCCESS) {
+                    return curAction;
+                }
+
+                fprintf(fileOut, "%s\t%s\t%llu\t%llu\t%llu\t%.4f\t%.1f\t%.1f\t%ld\n", corpus -> name,
+                        CODERS[k].name, size, result.compressedSize, result.headerSize,
+                        size ? (double)result.compressedSize / (double)size : 0,
+                        getSpeed(size, result.encodeTime), getSpeed(size, result.decodeTime), peakMemory);
+
+                //Tiny sizes are left out, the tables of contexts cost more than they save there
+                if (!CODERS[k].useContexts && !CODERS[k].useRans) {
+                    order0Size = result.compressedSize;
+                } else if (CODERS[k].useContexts && corpus -> hasContexts && size >= BENCHMARK_CHUNK_SIZE &&
+                        result.compressedSize >= order0Size) {
+                    return BENCHMARK_REGRESSION;
+                }
+            }
+        }
     }
 
     return SUCCESS;
 }
 
+//////////////
+
 ExitCodes start() {
     fileIn = stdin;
     fileOut = stdout;
@@ -569,9 +3144,15 @@ ExitCodes start() {
 
     switch (option) {
         case 'c':
-            return encoding();
+            return encoding(false, false);
+        case 'o':
+            return encoding(true, false);
+        case 'r':
+            return encoding(false, true);
         case 'd':
             return decoding();
+        case 'b':
+            return benchmark();
         default:
             return WRONG_INPUT;
     }
@@ -586,3 +3167,4 @@ int main() {
     return execution;
 }
 
+#endif
@@ -1,124 +1,2069 @@
 #include <stdio.h>
 #include <mm_malloc.h>
+#include <malloc.h>
+#include <string.h>
+#include <time.h>
+#include <limits.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "fastInput.h"
 
 typedef enum {
     SUCCESS,
     ERROR
 } ExitID;
 
+//AVL tree of 2^31 nodes is lower than that, so paths from the root fit in arrays
+#define MAX_TREE_HEIGHT 48
+
 typedef struct _node Node;
 
 struct _node {
     int value;
+    int size;
     unsigned char height;
     Node* left;
     Node* right;
 };
 
-unsigned char height(Node* vertice) {
-    return (unsigned char) (vertice ? vertice -> height : 0);
-}
+//Balancing is the same for every node type with left, right and height, so it is written once
+//and made for each type by name. Only fixHeight is written by the type, it is declared before
+#define DEFINE_AVL_BALANCING(NodeType, heightOf, balanceFactorOf, fixHeightOf, rotateLeftOf, rotateRightOf, balanceOf) \
+    unsigned char heightOf(NodeType* vertice) { \
+        return (unsigned char) (vertice ? vertice -> height : 0); \
+    } \
+    \
+    int balanceFactorOf(NodeType* vertice) { \
+        return heightOf(vertice -> right) - heightOf(vertice -> left); \
+    } \
+    \
+    NodeType* rotateLeftOf(NodeType* q) { \
+        NodeType* p = q -> right; \
+        q -> right = p -> left; \
+        p -> left = q; \
+        fixHeightOf(q); \
+        fixHeightOf(p); \
+        return p; \
+    } \
+    \
+    NodeType* rotateRightOf(NodeType* p) { \
+        NodeType* q = p -> left; \
+        p -> left = q -> right; \
+        q -> right = p; \
+        fixHeightOf(p); \
+        fixHeightOf(q); \
+        return q; \
+    } \
+    \
+    NodeType* balanceOf(NodeType* vertice) { \
+        fixHeightOf(vertice); \
+        if (balanceFactorOf(vertice) == 2) { \
+            if (balanceFactorOf(vertice -> right) < 0) { \
+                vertice -> right = rotateRightOf(vertice -> right); \
+            } \
+            vertice = rotateLeftOf(vertice); \
+        } \
+        if (balanceFactorOf(vertice) == -2) { \
+            if (balanceFactorOf(vertice -> left) > 0) { \
+                vertice -> left = rotateLeftOf(vertice -> left); \
+            } \
+            vertice = rotateRightOf(vertice); \
+        } \
+        \
+        return vertice; \
+    }
 
-int balanceFactor(Node* vertice) {
-    return height(vertice -> right) - height(vertice -> left);
+void fixHeight(Node* p);
+
+DEFINE_AVL_BALANCING(Node, height, balanceFactor, fixHeight, rotateLeft, rotateRight, balance)
+
+int subtreeSize(Node* vertice) {
+    return vertice ? vertice -> size : 0;
 }
 
+//Size of the subtree is fixed along with its height, so rotations keep both
 void fixHeight(Node* p) {
     unsigned char heightLeft = height(p -> left);
     unsigned char heightRight = height(p -> right);
     p -> height = (unsigned char)((heightLeft > heightRight ? heightLeft : heightRight) + 1);
+    p -> size = subtreeSize(p -> left) + subtreeSize(p -> right) + 1;
 }
 
-Node* rotateLeft(Node* q) {
-    Node* p = q -> right;
-    q -> right = p -> left;
-    p -> left = q;
-    fixHeight(q);
-    fixHeight(p);
-    return p;
+Node* createNode(int value) {
+    Node* newNode = (Node*)calloc(1, sizeof(Node));
+    if (!newNode) {
+        return NULL;
+    }
+    newNode -> value = value;
+    newNode -> size = 1;
+    newNode -> height = 1;
+    return newNode;
 }
 
-Node* rotateRight(Node* p) {
-    Node* q = p -> left;
-    p -> left = q -> right;
-    q -> right = p;
-    fixHeight(p);
-    fixHeight(q);
-    return q;
+//Node has to be made already, so the tree is changed only when memory was enough.
+//Path to the new leaf is kept on a stack, every node of it gets one more node below on the way
+//down. On the way up subtrees are balanced until one keeps its old height: nothing above it changes
+Node* insert(Node* root, Node* newNode) {
+    if (!root) {
+        return newNode;
+    }
+
+    int value = newNode -> value;
+    Node* path[MAX_TREE_HEIGHT];
+    int depth = 0;
+    for (Node* curNode = root; curNode; curNode = value <= curNode -> value ? curNode -> left : curNode -> right) {
+        curNode -> size++;
+        path[depth++] = curNode;
+    }
+
+    Node* parent = path[depth - 1];
+    if (value <= parent -> value) {
+        parent -> left = newNode;
+    } else {
+        parent -> right = newNode;
+    }
+
+    for (int i = depth - 1; i >= 0; i--) {
+        Node* vertice = path[i];
+        unsigned char oldHeight = vertice -> height;
+        Node* balanced = balance(vertice);
+
+        if (balanced != vertice) {
+            if (i == 0) {
+                root = balanced;
+            } else if (path[i - 1] -> left == vertice) {
+                path[i - 1] -> left = balanced;
+            } else {
+                path[i - 1] -> right = balanced;
+            }
+        }
+        if (balanced -> height == oldHeight) {
+            break;
+        }
+    }
+
+    return root;
 }
 
-Node* balance(Node* vertice) {
-    fixHeight(vertice);
-    if (balanceFactor(vertice) == 2) {
-        if (balanceFactor(vertice -> right) < 0) {
-            vertice -> right = rotateRight(vertice -> right);
+//Left child is rotated up until there is none, then the node goes and its right subtree is next.
+//Every rotation puts one node to the right spine for good, so it's linear and needs no stack
+void inOrderFree(Node* root) {
+    while (root) {
+        if (root -> left) {
+            Node* left = root -> left;
+            root -> left = left -> right;
+            left -> right = root;
+            root = left;
+        } else {
+            Node* right = root -> right;
+            free(root);
+            root = right;
         }
-        vertice = rotateLeft(vertice);
     }
-    if (balanceFactor(vertice) == -2) {
-        if (balanceFactor(vertice -> left) > 0) {
-            vertice -> left = rotateLeft(vertice -> left);
+}
+
+/////Tree
+
+typedef struct _tree Tree;
+
+struct _tree {
+    Node* root;
+};
+
+int getTreeSize(const Tree* tree) {
+    return subtreeSize(tree -> root);
+}
+
+int insertValue(Tree* tree, int value) {
+    Node* newNode = createNode(value);
+    if (!newNode) {
+        return ERROR;
+    }
+    tree -> root = insert(tree -> root, newNode);
+
+    return SUCCESS;
+}
+
+int containsValue(const Tree* tree, int value) {
+    Node* curNode = tree -> root;
+    while (curNode && curNode -> value != value) {
+        curNode = value < curNode -> value ? curNode -> left : curNode -> right;
+    }
+
+    return curNode != NULL;
+}
+
+void freeTree(Tree* tree) {
+    if (tree -> root) {
+        inOrderFree(tree -> root);
+    }
+    tree -> root = NULL;
+}
+
+/////Order statistics
+//Sizes of subtrees tell how many values are to the left of a node, so both queries go down one path
+
+//k-th smallest value counting from zero, k has to be less than the size
+int selectValue(const Tree* tree, int k, int* value) {
+    if (k < 0 || k >= getTreeSize(tree)) {
+        return ERROR;
+    }
+
+    Node* curNode = tree -> root;
+    while (k != subtreeSize(curNode -> left)) {
+        if (k < subtreeSize(curNode -> left)) {
+            curNode = curNode -> left;
+        } else {
+            k -= subtreeSize(curNode -> left) + 1;
+            curNode = curNode -> right;
         }
-        vertice = rotateRight(vertice);
     }
+    *value = curNode -> value;
 
-    return vertice;
+    return SUCCESS;
 }
 
-Node* createNode(int value) {
-    Node* newNode = (Node*)calloc(1, sizeof(Node));
-    newNode -> value = value;
-    newNode -> height = 1;
-    return newNode;
+//Number of values which are less than value
+int rankValue(const Tree* tree, int value) {
+    int rank = 0;
+    Node* curNode = tree -> root;
+    while (curNode) {
+        if (curNode -> value < value) {
+            rank += subtreeSize(curNode -> left) + 1;
+            curNode = curNode -> right;
+        } else {
+            curNode = curNode -> left;
+        }
+    }
+
+    return rank;
 }
 
-Node* insert(Node* root, int value) {
-    if (height(root) == 0) {
-        return createNode(value);
-    } else if (value <= root -> value) {
-        root -> left = insert(root -> left, value);
-    } else {
-        root -> right = insert(root -> right, value);
+/////Bulk loading
+//Sorted nodes are linked so that halves of every subtree differ by one node at most: it's an AVL
+//tree already and nothing has to be rotated. Every node is touched once
+
+int compareValues(const void* a, const void* b) {
+    int first = *(const int*)a;
+    int second = *(const int*)b;
+
+    return (first > second) - (first < second);
+}
+
+int isSorted(const int* values, int count) {
+    for (int i = 1; i < count; i++) {
+        if (values[i - 1] > values[i]) {
+            return 0;
+        }
     }
 
-    return balance(root);
+    return 1;
 }
 
-void inOrderFree(Node* root) {
-    if (root -> left) {
-        inOrderFree(root -> left);
+void sortValues(int* values, int count) {
+    if (!isSorted(values, count)) {
+        qsort(values, (size_t)count, sizeof(int), compareValues);
     }
-    if (root -> right) {
-        inOrderFree(root -> right);
+}
+
+Node* linkBalanced(Node** nodes, int count) {
+    if (count == 0) {
+        return NULL;
     }
-    free(root);
+
+    int middle = count / 2;
+    Node* root = nodes[middle];
+    root -> left = linkBalanced(nodes, middle);
+    root -> right = linkBalanced(nodes + middle + 1, count - middle - 1);
+    fixHeight(root);
+
+    return root;
 }
 
-int createAVL() {
-    Node* root = NULL;
-    int n;
-    if (scanf("%d", &n) == 0) {
-        printf("Bad input");
-        free(root);
+//Nodes go to the array in order, index of the next free place is returned
+int collectNodes(Node* root, Node** nodes, int index) {
+    if (!root) {
+        return index;
+    }
+
+    index = collectNodes(root -> left, nodes, index);
+    nodes[index++] = root;
+
+    return collectNodes(root -> right, nodes, index);
+}
+
+//Nodes of the batch are made at once, so nothing is changed when memory runs out
+Node** createNodes(const int* values, int count) {
+    Node** nodes = (Node**)malloc((size_t)(count ? count : 1) * sizeof(Node*));
+    if (!nodes) {
+        return NULL;
+    }
+
+    for (int i = 0; i < count; i++) {
+        nodes[i] = createNode(values[i]);
+        if (!nodes[i]) {
+            while (i-- > 0) {
+                free(nodes[i]);
+            }
+            free(nodes);
+            return NULL;
+        }
+    }
+
+    return nodes;
+}
+
+//Tree has to be empty, values are sorted in place
+int bulkBuild(Tree* tree, int* values, int count) {
+    sortValues(values, count);
+
+    Node** nodes = createNodes(values, count);
+    if (!nodes) {
         return ERROR;
-    } else for (int i = 0; i < n; i++) {
-            int current;
-            if (scanf("%d", &current) == 0) {
-                printf("Bad input");
+    }
+
+    tree -> root = linkBalanced(nodes, count);
+    free(nodes);
+
+    return SUCCESS;
+}
+
+//Batch is sorted in place. Small batch goes by single inserts, a big one is merged with nodes of
+//the tree in order and the tree is linked anew: O(n + m) instead of O(m log(n + m))
+int insertBatch(Tree* tree, int* values, int count) {
+    sortValues(values, count);
+
+    int size = getTreeSize(tree);
+    if ((long long)count * (height(tree -> root) + 1) < (long long)size + count) {
+        for (int i = 0; i < count; i++) {
+            if (insertValue(tree, values[i]) != SUCCESS) {
                 return ERROR;
             }
-            root = insert(root, current);
         }
 
-    printf("%d", height(root));
+        return SUCCESS;
+    }
+
+    Node** batch = createNodes(values, count);
+    Node** nodes = (Node**)malloc(((size_t)size + (size_t)count + 1) * sizeof(Node*));
+    if (!batch || !nodes) {
+        if (batch) {
+            for (int i = 0; i < count; i++) {
+                free(batch[i]);
+            }
+        }
+        free(batch);
+        free(nodes);
+        return ERROR;
+    }
+
+    //Merging goes from the end, nodes of the tree are moved to their places before they are overwritten
+    int treeIndex = collectNodes(tree -> root, nodes, 0) - 1;
+    int batchIndex = count - 1;
+    for (int place = size + count - 1; batchIndex >= 0; place--) {
+        if (treeIndex >= 0 && nodes[treeIndex] -> value > batch[batchIndex] -> value) {
+            nodes[place] = nodes[treeIndex--];
+        } else {
+            nodes[place] = batch[batchIndex--];
+        }
+    }
+
+    tree -> root = linkBalanced(nodes, size + count);
+    free(batch);
+    free(nodes);
+
+    return SUCCESS;
+}
+
+//////////////////
+
+/////Node pool
+//Nodes live in one array and refer to each other by 32-bit indices, index 0 is the empty tree.
+//Node takes 16 bytes instead of 24 and the malloc header, allocation is a bump and the whole tree
+//is freed at once. Pool grows by half, so indices stay valid while addresses don't: nothing keeps
+//a pointer to a node over an allocation
+
+#define POOL_START_CAPACITY 1024
+
+typedef unsigned int NodeIndex;
+typedef struct _pool_node PoolNode;
+typedef struct _node_pool NodePool;
+
+struct _pool_node {
+    int value;
+    NodeIndex left;
+    NodeIndex right;
+    unsigned char height;
+};
+
+struct _node_pool {
+    PoolNode* nodes;
+    NodeIndex used;
+    NodeIndex capacity;
+    NodeIndex root;
+};
+
+//Node 0 is never given away, it stands for the empty tree with zero height
+int initNodePool(NodePool* pool) {
+    pool -> nodes = (PoolNode*)calloc(POOL_START_CAPACITY, sizeof(PoolNode));
+    if (!pool -> nodes) {
+        return ERROR;
+    }
+    pool -> used = 1;
+    pool -> capacity = POOL_START_CAPACITY;
+    pool -> root = 0;
 
+    return SUCCESS;
+}
+
+void freeNodePool(NodePool* pool) {
+    free(pool -> nodes);
+    pool -> nodes = NULL;
+    pool -> used = pool -> capacity = pool -> root = 0;
+}
+
+//After that count nodes can be taken without failures
+int reservePoolNodes(NodePool* pool, NodeIndex count) {
+    if (count > UINT_MAX - pool -> used) {
+        return ERROR;
+    }
+    if (pool -> used + count <= pool -> capacity) {
+        return SUCCESS;
+    }
+
+    //Single nodes make it grow by half, a big reserve is taken exactly
+    NodeIndex capacity = pool -> capacity < UINT_MAX / 3 * 2 ? pool -> capacity + pool -> capacity / 2 : UINT_MAX;
+    if (capacity < pool -> used + count) {
+        capacity = pool -> used + count;
+    }
+
+    PoolNode* nodes = (PoolNode*)realloc(pool -> nodes, (size_t)capacity * sizeof(PoolNode));
+    if (!nodes) {
+        return ERROR;
+    }
+    pool -> nodes = nodes;
+    pool -> capacity = capacity;
+
+    return SUCCESS;
+}
+
+NodeIndex takePoolNode(NodePool* pool, int value) {
+    NodeIndex index = pool -> used++;
+    pool -> nodes[index] = (PoolNode){value, 0, 0, 1};
+
+    return index;
+}
+
+unsigned char poolHeight(const NodePool* pool, NodeIndex vertice) {
+    return pool -> nodes[vertice].height;
+}
+
+int poolBalanceFactor(const NodePool* pool, NodeIndex vertice) {
+    return poolHeight(pool, pool -> nodes[vertice].right) - poolHeight(pool, pool -> nodes[vertice].left);
+}
+
+void poolFixHeight(NodePool* pool, NodeIndex p) {
+    unsigned char heightLeft = poolHeight(pool, pool -> nodes[p].left);
+    unsigned char heightRight = poolHeight(pool, pool -> nodes[p].right);
+    pool -> nodes[p].height = (unsigned char)((heightLeft > heightRight ? heightLeft : heightRight) + 1);
+}
+
+NodeIndex poolRotateLeft(NodePool* pool, NodeIndex q) {
+    NodeIndex p = pool -> nodes[q].right;
+    pool -> nodes[q].right = pool -> nodes[p].left;
+    pool -> nodes[p].left = q;
+    poolFixHeight(pool, q);
+    poolFixHeight(pool, p);
+    return p;
+}
+
+NodeIndex poolRotateRight(NodePool* pool, NodeIndex p) {
+    NodeIndex q = pool -> nodes[p].left;
+    pool -> nodes[p].left = pool -> nodes[q].right;
+    pool -> nodes[q].right = p;
+    poolFixHeight(pool, p);
+    poolFixHeight(pool, q);
+    return q;
+}
+
+NodeIndex poolBalance(NodePool* pool, NodeIndex vertice) {
+    poolFixHeight(pool, vertice);
+    if (poolBalanceFactor(pool, vertice) == 2) {
+        if (poolBalanceFactor(pool, pool -> nodes[vertice].right) < 0) {
+            pool -> nodes[vertice].right = poolRotateRight(pool, pool -> nodes[vertice].right);
+        }
+        vertice = poolRotateLeft(pool, vertice);
+    }
+    if (poolBalanceFactor(pool, vertice) == -2) {
+        if (poolBalanceFactor(pool, pool -> nodes[vertice].left) > 0) {
+            pool -> nodes[vertice].left = poolRotateLeft(pool, pool -> nodes[vertice].left);
+        }
+        vertice = poolRotateRight(pool, vertice);
+    }
+
+    return vertice;
+}
+
+//Node has to be reserved already
+NodeIndex poolInsert(NodePool* pool, NodeIndex root, int value) {
+    if (root == 0) {
+        return takePoolNode(pool, value);
+    } else if (value <= pool -> nodes[root].value) {
+        pool -> nodes[root].left = poolInsert(pool, pool -> nodes[root].left, value);
+    } else {
+        pool -> nodes[root].right = poolInsert(pool, pool -> nodes[root].right, value);
+    }
+
+    return poolBalance(pool, root);
+}
+
+int poolInsertValue(NodePool* pool, int value) {
+    if (reservePoolNodes(pool, 1) != SUCCESS) {
+        return ERROR;
+    }
+    pool -> root = poolInsert(pool, pool -> root, value);
+
+    return SUCCESS;
+}
+
+//Sorted nodes are next to each other in the pool, linked the same way as linkBalanced() does
+NodeIndex poolLinkBalanced(NodePool* pool, NodeIndex first, NodeIndex count) {
+    if (count == 0) {
+        return 0;
+    }
+
+    NodeIndex middle = first + count / 2;
+    pool -> nodes[middle].left = poolLinkBalanced(pool, first, count / 2);
+    pool -> nodes[middle].right = poolLinkBalanced(pool, middle + 1, count - count / 2 - 1);
+    poolFixHeight(pool, middle);
+
+    return middle;
+}
+
+//Pool has to be empty, values are sorted in place
+int poolBulkBuild(NodePool* pool, int* values, int count) {
+    sortValues(values, count);
+    if (reservePoolNodes(pool, (NodeIndex)count) != SUCCESS) {
+        return ERROR;
+    }
+
+    NodeIndex first = pool -> used;
+    for (int i = 0; i < count; i++) {
+        takePoolNode(pool, values[i]);
+    }
+    pool -> root = poolLinkBalanced(pool, first, (NodeIndex)count);
+
+    return SUCCESS;
+}
+
+//////////////////
+
+/////Ordered map
+//Unique keys with values on the same AVL balancing. Iterators keep the path from the root, since
+//nodes don't know their parents: the current node is on top, under it are the ancestors whose
+//keys are still ahead
+
+typedef struct _map_node MapNode;
+typedef struct _ordered_map OrderedMap;
+typedef struct _map_iterator MapIterator;
+
+struct _map_node {
+    int key;
+    int value;
+    unsigned char height;
+    MapNode* left;
+    MapNode* right;
+};
+
+struct _ordered_map {
+    MapNode* root;
+    int size;
+};
+
+struct _map_iterator {
+    MapNode* path[MAX_TREE_HEIGHT];
+    int depth;
+};
+
+typedef void (*MapVisitor)(int key, int value, void* context);
+
+void mapFixHeight(MapNode* p);
+
+DEFINE_AVL_BALANCING(MapNode, mapHeight, mapBalanceFactor, mapFixHeight, mapRotateLeft, mapRotateRight, mapBalance)
+
+void mapFixHeight(MapNode* p) {
+    unsigned char heightLeft = mapHeight(p -> left);
+    unsigned char heightRight = mapHeight(p -> right);
+    p -> height = (unsigned char)((heightLeft > heightRight ? heightLeft : heightRight) + 1);
+}
+
+void initMap(OrderedMap* map) {
+    map -> root = NULL;
+    map -> size = 0;
+}
+
+void freeMapNodes(MapNode* root) {
     if (root) {
-        inOrderFree(root);
+        freeMapNodes(root -> left);
+        freeMapNodes(root -> right);
+        free(root);
+    }
+}
+
+void freeMap(OrderedMap* map) {
+    freeMapNodes(map -> root);
+    initMap(map);
+}
+
+//Returns the place of the value, NULL when there is no such key
+int* mapFind(const OrderedMap* map, int key) {
+    MapNode* curNode = map -> root;
+    while (curNode && curNode -> key != key) {
+        curNode = key < curNode -> key ? curNode -> left : curNode -> right;
+    }
+
+    return curNode ? &curNode -> value : NULL;
+}
+
+//New node goes to the place of its key, when the key is there only the value is taken from it
+MapNode* mapPutNode(MapNode* root, MapNode* newNode, int* isReplaced) {
+    if (!root) {
+        return newNode;
+    }
+
+    if (newNode -> key < root -> key) {
+        root -> left = mapPutNode(root -> left, newNode, isReplaced);
+    } else if (newNode -> key > root -> key) {
+        root -> right = mapPutNode(root -> right, newNode, isReplaced);
+    } else {
+        root -> value = newNode -> value;
+        *isReplaced = 1;
+        return root;
+    }
+
+    return mapBalance(root);
+}
+
+//Value of the present key is replaced
+int mapPut(OrderedMap* map, int key, int value) {
+    MapNode* newNode = (MapNode*)malloc(sizeof(MapNode));
+    if (!newNode) {
+        return ERROR;
+    }
+    *newNode = (MapNode){key, value, 1, NULL, NULL};
+
+    int isReplaced = 0;
+    map -> root = mapPutNode(map -> root, newNode, &isReplaced);
+    if (isReplaced) {
+        free(newNode);
+    } else {
+        map -> size++;
     }
 
     return SUCCESS;
 }
 
-int main() {
+MapNode* detachMinimum(MapNode* root, MapNode** minimum) {
+    if (!root -> left) {
+        *minimum = root;
+        return root -> right;
+    }
+
+    root -> left = detachMinimum(root -> left, minimum);
+    return mapBalance(root);
+}
+
+MapNode* mapEraseNode(MapNode* root, int key, int* isErased) {
+    if (!root) {
+        return NULL;
+    }
+
+    if (key < root -> key) {
+        root -> left = mapEraseNode(root -> left, key, isErased);
+    } else if (key > root -> key) {
+        root -> right = mapEraseNode(root -> right, key, isErased);
+    } else {
+        //Node is replaced by the smallest one of its right subtree
+        MapNode* left = root -> left;
+        MapNode* right = root -> right;
+        free(root);
+        *isErased = 1;
+
+        if (!right) {
+            return left;
+        }
+        MapNode* minimum;
+        right = detachMinimum(right, &minimum);
+        minimum -> left = left;
+        minimum -> right = right;
+        return mapBalance(minimum);
+    }
+
+    return mapBalance(root);
+}
+
+//Returns 1 when the key was there
+int mapErase(OrderedMap* map, int key) {
+    int isErased = 0;
+    map -> root = mapEraseNode(map -> root, key, &isErased);
+    map -> size -= isErased;
+
+    return isErased;
+}
+
+//Left spine of the subtree goes on the path, the smallest key is on top
+void pushLeftSpine(MapIterator* iterator, MapNode* curNode) {
+    while (curNode) {
+        iterator -> path[iterator -> depth++] = curNode;
+        curNode = curNode -> left;
+    }
+}
+
+void mapBegin(const OrderedMap* map, MapIterator* iterator) {
+    iterator -> depth = 0;
+    pushLeftSpine(iterator, map -> root);
+}
+
+//Iterator stops at the first key which is not less than key (or greater when isStrict)
+void findBound(const OrderedMap* map, int key, int isStrict, MapIterator* iterator) {
+    iterator -> depth = 0;
+    MapNode* curNode = map -> root;
+    while (curNode) {
+        if (curNode -> key > key || (!isStrict && curNode -> key == key)) {
+            iterator -> path[iterator -> depth++] = curNode;
+            curNode = curNode -> left;
+        } else {
+            curNode = curNode -> right;
+        }
+    }
+}
+
+void mapLowerBound(const OrderedMap* map, int key, MapIterator* iterator) {
+    findBound(map, key, 0, iterator);
+}
+
+void mapUpperBound(const OrderedMap* map, int key, MapIterator* iterator) {
+    findBound(map, key, 1, iterator);
+}
+
+int mapIsEnd(const MapIterator* iterator) {
+    return iterator -> depth == 0;
+}
+
+MapNode* mapCurrent(const MapIterator* iterator) {
+    return iterator -> path[iterator -> depth - 1];
+}
+
+void mapNext(MapIterator* iterator) {
+    MapNode* curNode = iterator -> path[--iterator -> depth];
+    pushLeftSpine(iterator, curNode -> right);
+}
+
+//Visits keys from [from, to) in order, returns their number
+int mapForRange(const OrderedMap* map, int from, int to, MapVisitor visit, void* context) {
+    int count = 0;
+    MapIterator iterator;
+    for (mapLowerBound(map, from, &iterator); !mapIsEnd(&iterator) && mapCurrent(&iterator) -> key < to;
+            mapNext(&iterator)) {
+        visit(mapCurrent(&iterator) -> key, mapCurrent(&iterator) -> value, context);
+        count++;
+    }
+
+    return count;
+}
+
+//////////////////
+
+/////Concurrent tree
+//Readers never lock: the writer copies the path it changes and publishes the new root at once, so
+//a reader sees either the old tree or the new one. Insertion rotates only nodes of its path, and
+//those are the copies. Writers are serialized by a mutex. Replaced nodes are freed when no reader
+//can reach them: every reader announces the epoch it started in, nodes retired in an epoch are
+//freed once all readers are idle or started later
+
+#define MAX_READERS 64
+#define CACHE_LINE 64
+#define MAX_PATH_LENGTH (MAX_TREE_HEIGHT + 1)
+
+typedef struct _reader_slot ReaderSlot;
+typedef struct _retired_node RetiredNode;
+typedef struct _concurrent_tree ConcurrentTree;
+
+//Slots are in different cache lines, readers don't disturb each other. Zero epoch means idle
+struct _reader_slot {
+    unsigned long long epoch;
+    int isTaken;
+    char padding[CACHE_LINE - sizeof(unsigned long long) - sizeof(int)];
+};
+
+struct _retired_node {
+    Node* node;
+    unsigned long long epoch;
+};
+
+struct _concurrent_tree {
+    ReaderSlot readers[MAX_READERS];
+    Node* root;
+    unsigned long long epoch;
+    pthread_mutex_t writeLock;
+    RetiredNode* retired;
+    int retiredCount;
+    int retiredCapacity;
+};
+
+//Nodes of the tree are taken over, it becomes empty
+ConcurrentTree* createConcurrentTree(Tree* tree) {
+    ConcurrentTree* concurrentTree = (ConcurrentTree*)_mm_malloc(sizeof(ConcurrentTree), CACHE_LINE);
+    if (!concurrentTree) {
+        return NULL;
+    }
+
+    memset(concurrentTree, 0, sizeof(ConcurrentTree));
+    concurrentTree -> root = tree -> root;
+    concurrentTree -> epoch = 1;
+    pthread_mutex_init(&concurrentTree -> writeLock, NULL);
+    tree -> root = NULL;
+
+    return concurrentTree;
+}
+
+//No reader may be inside
+void freeConcurrentTree(ConcurrentTree* tree) {
+    for (int i = 0; i < tree -> retiredCount; i++) {
+        free(tree -> retired[i].node);
+    }
+    free(tree -> retired);
+    if (tree -> root) {
+        inOrderFree(tree -> root);
+    }
+
+    pthread_mutex_destroy(&tree -> writeLock);
+    _mm_free(tree);
+}
+
+//Every reading thread takes a free slot and gives it back when it is done, -1 means all are taken
+int registerReader(ConcurrentTree* tree) {
+    for (int slot = 0; slot < MAX_READERS; slot++) {
+        int isFree = 0;
+        if (__atomic_compare_exchange_n(&tree -> readers[slot].isTaken, &isFree, 1, 0, __ATOMIC_SEQ_CST,
+                __ATOMIC_RELAXED)) {
+            return slot;
+        }
+    }
+
+    return -1;
+}
+
+//Reader has to be outside of beginRead and endRead
+void unregisterReader(ConcurrentTree* tree, int slot) {
+    __atomic_store_n(&tree -> readers[slot].epoch, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&tree -> readers[slot].isTaken, 0, __ATOMIC_RELEASE);
+}
+
+//Epoch is announced before the root is taken: a writer who doesn't see it yet has published its root already
+Node* beginRead(ConcurrentTree* tree, int slot) {
+    unsigned long long epoch = __atomic_load_n(&tree -> epoch, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&tree -> readers[slot].epoch, epoch, __ATOMIC_SEQ_CST);
+
+    return __atomic_load_n(&tree -> root, __ATOMIC_SEQ_CST);
+}
+
+void endRead(ConcurrentTree* tree, int slot) {
+    __atomic_store_n(&tree -> readers[slot].epoch, 0, __ATOMIC_RELEASE);
+}
+
+int concurrentContains(ConcurrentTree* tree, int slot, int value) {
+    Node* curNode = beginRead(tree, slot);
+    while (curNode && curNode -> value != value) {
+        curNode = value < curNode -> value ? curNode -> left : curNode -> right;
+    }
+    endRead(tree, slot);
+
+    return curNode != NULL;
+}
+
+//Every node of the path is replaced by a spare one, the old ones are put to replaced
+Node* copyInsert(Node* root, int value, Node** spare, int* spareUsed, Node** replaced, int* replacedCount) {
+    Node* copy = spare[(*spareUsed)++];
+    if (!root) {
+        *copy = (Node){value, 1, 1, NULL, NULL};
+        return copy;
+    }
+
+    *copy = *root;
+    replaced[(*replacedCount)++] = root;
+    if (value <= copy -> value) {
+        copy -> left = copyInsert(copy -> left, value, spare, spareUsed, replaced, replacedCount);
+    } else {
+        copy -> right = copyInsert(copy -> right, value, spare, spareUsed, replaced, replacedCount);
+    }
+
+    return balance(copy);
+}
+
+//Frees retired nodes which nobody can reach, the writer lock has to be taken
+void reclaimNodes(ConcurrentTree* tree) {
+    unsigned long long oldestEpoch = ULLONG_MAX;
+    for (int i = 0; i < MAX_READERS; i++) {
+        unsigned long long epoch = __atomic_load_n(&tree -> readers[i].epoch, __ATOMIC_SEQ_CST);
+        if (epoch != 0 && epoch < oldestEpoch) {
+            oldestEpoch = epoch;
+        }
+    }
+
+    int kept = 0;
+    for (int i = 0; i < tree -> retiredCount; i++) {
+        if (tree -> retired[i].epoch < oldestEpoch) {
+            free(tree -> retired[i].node);
+        } else {
+            tree -> retired[kept++] = tree -> retired[i];
+        }
+    }
+    tree -> retiredCount = kept;
+}
+
+//Everything is allocated before the tree is changed, so a failure leaves it as it was
+int concurrentInsert(ConcurrentTree* tree, int value) {
+    pthread_mutex_lock(&tree -> writeLock);
+
+    Node* root = tree -> root;
+    int pathLength = height(root) + 1;
+    Node* spare[MAX_PATH_LENGTH];
+    int spareCount = 0;
+    if (pathLength > MAX_PATH_LENGTH) {
+        pthread_mutex_unlock(&tree -> writeLock);
+        return ERROR;
+    }
+    while (spareCount < pathLength) {
+        spare[spareCount] = (Node*)malloc(sizeof(Node));
+        if (!spare[spareCount]) {
+            break;
+        }
+        spareCount++;
+    }
+
+    if (spareCount == pathLength && tree -> retiredCount + pathLength > tree -> retiredCapacity) {
+        int capacity = 2 * tree -> retiredCapacity + pathLength;
+        RetiredNode* retired = (RetiredNode*)realloc(tree -> retired, (size_t)capacity * sizeof(RetiredNode));
+        if (retired) {
+            tree -> retired = retired;
+            tree -> retiredCapacity = capacity;
+        }
+    }
+    if (spareCount < pathLength || tree -> retiredCount + pathLength > tree -> retiredCapacity) {
+        while (spareCount > 0) {
+            free(spare[--spareCount]);
+        }
+        pthread_mutex_unlock(&tree -> writeLock);
+        return ERROR;
+    }
+
+    Node* replaced[MAX_PATH_LENGTH];
+    int spareUsed = 0, replacedCount = 0;
+    Node* newRoot = copyInsert(root, value, spare, &spareUsed, replaced, &replacedCount);
+    __atomic_store_n(&tree -> root, newRoot, __ATOMIC_SEQ_CST);
+
+    //Readers which have started before the next epoch may still walk the replaced nodes
+    unsigned long long epoch = __atomic_fetch_add(&tree -> epoch, 1, __ATOMIC_SEQ_CST);
+    for (int i = 0; i < replacedCount; i++) {
+        tree -> retired[tree -> retiredCount++] = (RetiredNode){replaced[i], epoch};
+    }
+    while (spareUsed < spareCount) {
+        free(spare[--spareCount]);
+    }
+    reclaimNodes(tree);
+
+    pthread_mutex_unlock(&tree -> writeLock);
+    return SUCCESS;
+}
+
+//////////////////
+
+/////B+-tree
+//Alternative index with the same insert, height and lookup. Node takes BTREE_NODE_SIZE bytes (four
+//cache lines) and holds dozens of keys, so a lookup misses the cache once per level of a tree which
+//is several times lower. Values are only in leaves, which are linked in order. Equal values go to
+//the right on insert, lookup takes the leftmost leaf where the value may be and its next one
+
+#define BTREE_NODE_SIZE 256
+#define LEAF_KEYS ((BTREE_NODE_SIZE - 2 * (int)sizeof(int) - (int)sizeof(void*)) / (int)sizeof(int))
+#define INNER_KEYS ((BTREE_NODE_SIZE - 2 * (int)sizeof(int) - (int)sizeof(void*)) / \
+        ((int)sizeof(int) + (int)sizeof(void*)))
+
+typedef struct _btree_node BTreeNode;
+typedef struct _btree BTree;
+
+struct _btree_node {
+    int count;
+    int isLeaf;
+    union {
+        struct {
+            int keys[LEAF_KEYS];
+            BTreeNode* next;
+        } leaf;
+        struct {
+            int keys[INNER_KEYS];
+            BTreeNode* children[INNER_KEYS + 1];
+        } inner;
+    };
+};
+
+//Spare nodes are taken before an insert: a split may go up to the root, and it can't fail on the way
+struct _btree {
+    BTreeNode* root;
+    int height;
+    BTreeNode* spare[MAX_TREE_HEIGHT + 1];
+    int spareCount;
+};
+
+void initBTree(BTree* tree) {
+    memset(tree, 0, sizeof(BTree));
+}
+
+void freeBTreeNodes(BTreeNode* node) {
+    if (!node -> isLeaf) {
+        for (int i = 0; i <= node -> count; i++) {
+            freeBTreeNodes(node -> inner.children[i]);
+        }
+    }
+    _mm_free(node);
+}
+
+void freeBTree(BTree* tree) {
+    if (tree -> root) {
+        freeBTreeNodes(tree -> root);
+    }
+    while (tree -> spareCount > 0) {
+        _mm_free(tree -> spare[--tree -> spareCount]);
+    }
+    initBTree(tree);
+}
+
+int btreeHeight(const BTree* tree) {
+    return tree -> height;
+}
+
+BTreeNode* takeBTreeNode(BTree* tree, int isLeaf) {
+    BTreeNode* node = tree -> spare[--tree -> spareCount];
+    node -> count = 0;
+    node -> isLeaf = isLeaf;
+
+    return node;
+}
+
+//Number of keys which are less than key (or not greater when isUpper)
+int findKeyPlace(const int* keys, int count, int key, int isUpper) {
+    int place = 0;
+    while (place < count && (keys[place] < key || (isUpper && keys[place] == key))) {
+        place++;
+    }
+
+    return place;
+}
+
+int btreeContains(const BTree* tree, int value) {
+    const BTreeNode* node = tree -> root;
+    if (!node) {
+        return 0;
+    }
+
+    while (!node -> isLeaf) {
+        node = node -> inner.children[findKeyPlace(node -> inner.keys, node -> count, value, 0)];
+    }
+
+    int place = findKeyPlace(node -> leaf.keys, node -> count, value, 0);
+    if (place == node -> count) {
+        node = node -> leaf.next;
+        place = 0;
+    }
+
+    return node && place < node -> count && node -> leaf.keys[place] == value;
+}
+
+//Returns the new right neighbour when the node was split, the least key under it goes to separator
+BTreeNode* btreeInsertInto(BTree* tree, BTreeNode* node, int value, int* separator) {
+    if (node -> isLeaf) {
+        int place = findKeyPlace(node -> leaf.keys, node -> count, value, 1);
+        if (node -> count < LEAF_KEYS) {
+            memmove(node -> leaf.keys + place + 1, node -> leaf.keys + place, (size_t)(node -> count - place) * sizeof(int));
+            node -> leaf.keys[place] = value;
+            node -> count++;
+            return NULL;
+        }
+
+        //Full leaf gives its higher half to the new one, the value goes to the half where it belongs
+        BTreeNode* right = takeBTreeNode(tree, 1);
+        int keys[LEAF_KEYS + 1];
+        memcpy(keys, node -> leaf.keys, (size_t)place * sizeof(int));
+        keys[place] = value;
+        memcpy(keys + place + 1, node -> leaf.keys + place, (size_t)(LEAF_KEYS - place) * sizeof(int));
+
+        node -> count = (LEAF_KEYS + 1) / 2;
+        right -> count = LEAF_KEYS + 1 - node -> count;
+        memcpy(node -> leaf.keys, keys, (size_t)node -> count * sizeof(int));
+        memcpy(right -> leaf.keys, keys + node -> count, (size_t)right -> count * sizeof(int));
+        right -> leaf.next = node -> leaf.next;
+        node -> leaf.next = right;
+
+        *separator = right -> leaf.keys[0];
+        return right;
+    }
+
+    int place = findKeyPlace(node -> inner.keys, node -> count, value, 1);
+    int childSeparator;
+    BTreeNode* newChild = btreeInsertInto(tree, node -> inner.children[place], value, &childSeparator);
+    if (!newChild) {
+        return NULL;
+    }
+
+    int keys[INNER_KEYS + 1];
+    BTreeNode* children[INNER_KEYS + 2];
+    memcpy(keys, node -> inner.keys, (size_t)place * sizeof(int));
+    keys[place] = childSeparator;
+    memcpy(keys + place + 1, node -> inner.keys + place, (size_t)(node -> count - place) * sizeof(int));
+    memcpy(children, node -> inner.children, (size_t)(place + 1) * sizeof(BTreeNode*));
+    children[place + 1] = newChild;
+    memcpy(children + place + 2, node -> inner.children + place + 1, (size_t)(node -> count - place) * sizeof(BTreeNode*));
+
+    int count = node -> count + 1;
+    if (count <= INNER_KEYS) {
+        node -> count = count;
+        memcpy(node -> inner.keys, keys, (size_t)count * sizeof(int));
+        memcpy(node -> inner.children, children, (size_t)(count + 1) * sizeof(BTreeNode*));
+        return NULL;
+    }
+
+    //Middle key goes up, keys around it are shared between the halves
+    BTreeNode* right = takeBTreeNode(tree, 0);
+    node -> count = count / 2;
+    right -> count = count - node -> count - 1;
+    memcpy(node -> inner.keys, keys, (size_t)node -> count * sizeof(int));
+    memcpy(node -> inner.children, children, (size_t)(node -> count + 1) * sizeof(BTreeNode*));
+    memcpy(right -> inner.keys, keys + node -> count + 1, (size_t)right -> count * sizeof(int));
+    memcpy(right -> inner.children, children + node -> count + 1, (size_t)(right -> count + 1) * sizeof(BTreeNode*));
+
+    *separator = keys[node -> count];
+    return right;
+}
+
+int btreeInsert(BTree* tree, int value) {
+    while (tree -> spareCount < tree -> height + 1) {
+        BTreeNode* node = (BTreeNode*)_mm_malloc(sizeof(BTreeNode), CACHE_LINE);
+        if (!node) {
+            return ERROR;
+        }
+        tree -> spare[tree -> spareCount++] = node;
+    }
+
+    if (!tree -> root) {
+        tree -> root = takeBTreeNode(tree, 1);
+        tree -> root -> leaf.next = NULL;
+        tree -> height = 1;
+    }
+
+    int separator;
+    BTreeNode* right = btreeInsertInto(tree, tree -> root, value, &separator);
+    if (right) {
+        BTreeNode* root = takeBTreeNode(tree, 0);
+        root -> count = 1;
+        root -> inner.keys[0] = separator;
+        root -> inner.children[0] = tree -> root;
+        root -> inner.children[1] = right;
+        tree -> root = root;
+        tree -> height++;
+    }
+
+    return SUCCESS;
+}
+
+//////////////////
+
+int createAVL() {
+    Node* root = NULL;
+    FastInput* input = standardInput();
+    int n = 0;
+    if (readInt(input, &n) == 0) {
+        printf("Bad input");
+        free(root);
+        return ERROR;
+    } else for (int i = 0; i < n; i++) {
+            int current = 0;
+            if (readInt(input, &current) == 0) {
+                printf("Bad input");
+                return ERROR;
+            }
+            Node* newNode = createNode(current);
+            if (!newNode) {
+                printf("Out of memory");
+                if (root) {
+                    inOrderFree(root);
+                }
+                return ERROR;
+            }
+            root = insert(root, newNode);
+        }
+
+    printf("%d", height(root));
+
+    if (root) {
+        inOrderFree(root);
+    }
+
+    return SUCCESS;
+}
+
+/////Benchmark
+//Run as "bench [keys]". Keys are put into an empty tree of both layouts one by one and at once,
+//then a sorted batch of the same size goes into a tree of random keys. Memory is the growth of
+//the heap while the tree is built, freeing of the tree is timed apart. Results are tab-separated lines
+
+#define BENCHMARK_KEYS (1 << 22)
+
+typedef enum {
+    SORTED_KEYS,
+    REVERSE_KEYS,
+    RANDOM_KEYS
+} KeyOrder;
+
+double getTime() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+
+size_t getHeapSize() {
+    struct mallinfo2 info = mallinfo2();
+
+    return info.uordblks + info.hblkhd;
+}
+
+unsigned int nextRandom(unsigned int* seed) {
+    *seed = *seed * 1103515245 + 12345;
+
+    return *seed >> 16;
+}
+
+int randomValue(unsigned int* seed) {
+    return (int)(nextRandom(seed) << 15 ^ nextRandom(seed));
+}
+
+void fillKeys(int* values, int count, KeyOrder order) {
+    unsigned int seed = 12345;
+    for (int i = 0; i < count; i++) {
+        if (order == RANDOM_KEYS) {
+            values[i] = randomValue(&seed);
+        } else {
+            values[i] = order == SORTED_KEYS ? 2 * i : 2 * (count - 1 - i);
+        }
+    }
+}
+
+void printResult(const char* name, int keys, double time, int treeHeight, size_t bytes, double freeTime) {
+    printf("%s\t%d\t%.3f\t%d\t%zu\t%.3f\n", name, keys, time, treeHeight, bytes, freeTime);
+}
+
+double timeTreeFree(Tree* tree) {
+    double begin = getTime();
+    freeTree(tree);
+
+    return getTime() - begin;
+}
+
+int runPointerCase(const char* name, int* values, int count, KeyOrder order, int isBulk) {
+    fillKeys(values, count, order);
+    Tree tree = {NULL};
+    size_t heapSize = getHeapSize();
+
+    double begin = getTime();
+    int result = SUCCESS;
+    if (isBulk) {
+        result = bulkBuild(&tree, values, count);
+    } else {
+        for (int i = 0; i < count && result == SUCCESS; i++) {
+            result = insertValue(&tree, values[i]);
+        }
+    }
+    double time = getTime() - begin;
+    size_t bytes = getHeapSize() - heapSize;
+    int treeHeight = height(tree.root);
+    printResult(name, count, time, treeHeight, bytes, timeTreeFree(&tree));
+
+    return result;
+}
+
+int runPoolCase(const char* name, int* values, int count, KeyOrder order, int isBulk) {
+    fillKeys(values, count, order);
+    NodePool pool;
+    size_t heapSize = getHeapSize();
+    if (initNodePool(&pool) != SUCCESS) {
+        return ERROR;
+    }
+
+    double begin = getTime();
+    int result = SUCCESS;
+    if (isBulk) {
+        result = poolBulkBuild(&pool, values, count);
+    } else {
+        for (int i = 0; i < count && result == SUCCESS; i++) {
+            result = poolInsertValue(&pool, values[i]);
+        }
+    }
+    double time = getTime() - begin;
+    size_t bytes = getHeapSize() - heapSize;
+    int treeHeight = poolHeight(&pool, pool.root);
+
+    begin = getTime();
+    freeNodePool(&pool);
+    printResult(name, count, time, treeHeight, bytes, getTime() - begin);
+
+    return result;
+}
+
+//Tree of random keys gets the batch by single inserts or as a whole
+int runBatchCase(const char* name, int* values, int count, int isBatch) {
+    Tree tree = {NULL};
+    unsigned int seed = 12345;
+    int result = SUCCESS;
+    for (int i = 0; i < count && result == SUCCESS; i++) {
+        result = insertValue(&tree, randomValue(&seed));
+    }
+    if (result != SUCCESS) {
+        freeTree(&tree);
+        return ERROR;
+    }
+    fillKeys(values, count, SORTED_KEYS);
+    size_t heapSize = getHeapSize();
+
+    double begin = getTime();
+    if (isBatch) {
+        result = insertBatch(&tree, values, count);
+    } else {
+        for (int i = 0; i < count && result == SUCCESS; i++) {
+            result = insertValue(&tree, values[i]);
+        }
+    }
+    double time = getTime() - begin;
+    size_t bytes = getHeapSize() - heapSize;
+    int treeHeight = height(tree.root);
+    printResult(name, count, time, treeHeight, bytes, timeTreeFree(&tree));
+
+    return result;
+}
+
+//Values are selected by their places and ranked in random order, a wrong answer stops the benchmark
+int runOrderCase(int* values, int count) {
+    fillKeys(values, count, RANDOM_KEYS);
+    Tree tree = {NULL};
+    int result = bulkBuild(&tree, values, count);
+
+    unsigned int seed = 777;
+    double begin = getTime();
+    for (int i = 0; i < count && result == SUCCESS; i++) {
+        int k = (int)((unsigned int)randomValue(&seed) % (unsigned int)count);
+        int value;
+        if (selectValue(&tree, k, &value) != SUCCESS || value != values[k]) {
+            result = ERROR;
+        }
+    }
+    printResult("select_random", count, getTime() - begin, height(tree.root), 0, 0);
+
+    begin = getTime();
+    for (int i = 0; i < count && result == SUCCESS; i++) {
+        int k = (int)((unsigned int)randomValue(&seed) % (unsigned int)count);
+        int rank = rankValue(&tree, values[k]);
+        if (values[rank] != values[k] || (rank > 0 && values[rank - 1] == values[k])) {
+            result = ERROR;
+        }
+    }
+    printResult("rank_random", count, getTime() - begin, height(tree.root), 0, 0);
+    freeTree(&tree);
+
+    return result;
+}
+
+int benchmark(int keys) {
+    int* values = (int*)malloc((size_t)(keys > 0 ? keys : 1) * sizeof(int));
+    if (!values) {
+        return ERROR;
+    }
+
+    printf("case\tkeys\tseconds\theight\tbytes\tfree_seconds\n");
+    int result = SUCCESS;
+    if (result == SUCCESS) {
+        result = runPointerCase("insert_sorted", values, keys, SORTED_KEYS, 0);
+    }
+    if (result == SUCCESS) {
+        result = runPointerCase("insert_reverse", values, keys, REVERSE_KEYS, 0);
+    }
+    if (result == SUCCESS) {
+        result = runPointerCase("insert_random", values, keys, RANDOM_KEYS, 0);
+    }
+    if (result == SUCCESS) {
+        result = runPointerCase("bulk_sorted", values, keys, SORTED_KEYS, 1);
+    }
+    if (result == SUCCESS) {
+        result = runPoolCase("pool_insert_sorted", values, keys, SORTED_KEYS, 0);
+    }
+    if (result == SUCCESS) {
+        result = runPoolCase("pool_insert_reverse", values, keys, REVERSE_KEYS, 0);
+    }
+    if (result == SUCCESS) {
+        result = runPoolCase("pool_insert_random", values, keys, RANDOM_KEYS, 0);
+    }
+    if (result == SUCCESS) {
+        result = runPoolCase("pool_bulk_sorted", values, keys, SORTED_KEYS, 1);
+    }
+    if (result == SUCCESS) {
+        result = runBatchCase("insert_batch_single", values, keys, 0);
+    }
+    if (result == SUCCESS) {
+        result = runBatchCase("insert_batch_merged", values, keys, 1);
+    }
+    if (result == SUCCESS && keys > 0) {
+        result = runOrderCase(values, keys);
+    }
+    free(values);
+
+    return result;
+}
+
+/////Map benchmark
+//Run as "bench-map [keys]". Ordered map is compared with a sorted array searched by halves and
+//with a static B-tree over the same array: BLOCK_KEYS keys of a block take one cache line and
+//blocks are laid out as a complete tree, block k has children k * (BLOCK_KEYS + 1) + i + 1.
+//Keys are even numbers in random order, value of a key is its half. Time is given per operation
+
+#define BLOCK_KEYS 16
+#define MAP_OPERATIONS (1 << 20)
+#define RANGE_SPAN 100
+
+typedef struct _sorted_index SortedIndex;
+typedef struct _static_btree StaticBTree;
+typedef struct _range_sum RangeSum;
+
+struct _sorted_index {
+    int* keys;
+    int* values;
+    int count;
+};
+
+//Every key of a block remembers its place in the sorted array, free places point to its end
+struct _static_btree {
+    int* keys;
+    int* positions;
+    int blockCount;
+};
+
+struct _range_sum {
+    long long sum;
+};
+
+//Place of the first key which is not less than key
+int sortedLowerBound(const SortedIndex* index, int key) {
+    int left = 0, right = index -> count;
+    while (left < right) {
+        int middle = left + (right - left) / 2;
+        if (index -> keys[middle] < key) {
+            left = middle + 1;
+        } else {
+            right = middle;
+        }
+    }
+
+    return left;
+}
+
+//Blocks are filled in order: children before and after every key of the block
+int fillStaticBlocks(StaticBTree* tree, const SortedIndex* index, int block, int place) {
+    if (block >= tree -> blockCount) {
+        return place;
+    }
+
+    for (int i = 0; i < BLOCK_KEYS; i++) {
+        place = fillStaticBlocks(tree, index, block * (BLOCK_KEYS + 1) + i + 1, place);
+        if (place < index -> count) {
+            tree -> keys[block * BLOCK_KEYS + i] = index -> keys[place];
+            tree -> positions[block * BLOCK_KEYS + i] = place++;
+        } else {
+            tree -> keys[block * BLOCK_KEYS + i] = INT_MAX;
+            tree -> positions[block * BLOCK_KEYS + i] = index -> count;
+        }
+    }
+
+    return fillStaticBlocks(tree, index, block * (BLOCK_KEYS + 1) + BLOCK_KEYS + 1, place);
+}
+
+int buildStaticBTree(StaticBTree* tree, const SortedIndex* index) {
+    tree -> blockCount = (index -> count + BLOCK_KEYS - 1) / BLOCK_KEYS;
+    size_t size = (size_t)(tree -> blockCount ? tree -> blockCount : 1) * BLOCK_KEYS * sizeof(int);
+    tree -> keys = (int*)_mm_malloc(size, 64);
+    tree -> positions = (int*)malloc(size);
+    if (!tree -> keys || !tree -> positions) {
+        _mm_free(tree -> keys);
+        free(tree -> positions);
+        return ERROR;
+    }
+
+    fillStaticBlocks(tree, index, 0, 0);
+    return SUCCESS;
+}
+
+void freeStaticBTree(StaticBTree* tree) {
+    _mm_free(tree -> keys);
+    free(tree -> positions);
+}
+
+//Gives the place in the sorted array like sortedLowerBound(). Key found deeper is never greater,
+//so only the last one is taken
+int staticLowerBound(const StaticBTree* tree, int key, int count) {
+    int found = -1;
+    int block = 0;
+    while (block < tree -> blockCount) {
+        const int* keys = tree -> keys + block * BLOCK_KEYS;
+        int i = 0;
+        for (int j = 0; j < BLOCK_KEYS; j++) {
+            i += keys[j] < key;
+        }
+
+        if (i < BLOCK_KEYS) {
+            found = block * BLOCK_KEYS + i;
+        }
+        block = block * (BLOCK_KEYS + 1) + i + 1;
+    }
+
+    return found < 0 ? count : tree -> positions[found];
+}
+
+void addToSum(int key, int value, void* context) {
+    (void)key;
+    ((RangeSum*)context) -> sum += value;
+}
+
+void printMapResult(const char* structure, const char* operation, int keys, double time, int operations,
+        long long check) {
+    printf("%s\t%s\t%d\t%.1f\t%lld\n", structure, operation, keys, time * 1e9 / operations, check);
+}
+
+//Keys which are looked for: half of them are in the map
+void fillQueries(int* queries, int keys) {
+    unsigned int seed = 777;
+    for (int i = 0; i < MAP_OPERATIONS; i++) {
+        queries[i] = (int)((unsigned int)randomValue(&seed) % (2 * (unsigned int)keys));
+    }
+}
+
+void runMapCases(int* keys, int count, const int* queries) {
+    OrderedMap map;
+    initMap(&map);
+
+    double begin = getTime();
+    for (int i = 0; i < count; i++) {
+        mapPut(&map, keys[i], keys[i] / 2);
+    }
+    printMapResult("avl_map", "build", count, getTime() - begin, count, map.size);
+
+    long long check = 0;
+    begin = getTime();
+    for (int i = 0; i < MAP_OPERATIONS; i++) {
+        int* value = mapFind(&map, queries[i]);
+        check += value ? *value : 0;
+    }
+    printMapResult("avl_map", "find", count, getTime() - begin, MAP_OPERATIONS, check);
+
+    check = 0;
+    begin = getTime();
+    for (int i = 0; i < MAP_OPERATIONS; i++) {
+        MapIterator iterator;
+        mapLowerBound(&map, queries[i], &iterator);
+        check += mapIsEnd(&iterator) ? 0 : mapCurrent(&iterator) -> key;
+    }
+    printMapResult("avl_map", "lower_bound", count, getTime() - begin, MAP_OPERATIONS, check);
+
+    RangeSum range = {0};
+    begin = getTime();
+    for (int i = 0; i < MAP_OPERATIONS / RANGE_SPAN; i++) {
+        mapForRange(&map, queries[i], queries[i] + 2 * RANGE_SPAN, addToSum, &range);
+    }
+    printMapResult("avl_map", "range", count, getTime() - begin, MAP_OPERATIONS / RANGE_SPAN, range.sum);
+
+    check = 0;
+    begin = getTime();
+    for (int i = 0; i < MAP_OPERATIONS; i++) {
+        check += mapErase(&map, queries[i]);
+    }
+    printMapResult("avl_map", "erase", count, getTime() - begin, MAP_OPERATIONS, check);
+
+    freeMap(&map);
+}
+
+//Both are searched in the same sorted array, only the way to the place differs
+void runArrayCases(const SortedIndex* index, const StaticBTree* tree, const int* queries, int isTree) {
+    const char* name = isTree ? "static_btree" : "sorted_array";
+    long long check = 0;
+    double begin = getTime();
+    for (int i = 0; i < MAP_OPERATIONS; i++) {
+        int place = isTree ? staticLowerBound(tree, queries[i], index -> count) : sortedLowerBound(index, queries[i]);
+        check += place < index -> count && index -> keys[place] == queries[i] ? index -> values[place] : 0;
+    }
+    printMapResult(name, "find", index -> count, getTime() - begin, MAP_OPERATIONS, check);
+
+    check = 0;
+    begin = getTime();
+    for (int i = 0; i < MAP_OPERATIONS; i++) {
+        int place = isTree ? staticLowerBound(tree, queries[i], index -> count) : sortedLowerBound(index, queries[i]);
+        check += place < index -> count ? index -> keys[place] : 0;
+    }
+    printMapResult(name, "lower_bound", index -> count, getTime() - begin, MAP_OPERATIONS, check);
+
+    RangeSum range = {0};
+    begin = getTime();
+    for (int i = 0; i < MAP_OPERATIONS / RANGE_SPAN; i++) {
+        int place = isTree ? staticLowerBound(tree, queries[i], index -> count) : sortedLowerBound(index, queries[i]);
+        for (; place < index -> count && index -> keys[place] < queries[i] + 2 * RANGE_SPAN; place++) {
+            addToSum(index -> keys[place], index -> values[place], &range);
+        }
+    }
+    printMapResult(name, "range", index -> count, getTime() - begin, MAP_OPERATIONS / RANGE_SPAN, range.sum);
+}
+
+int mapBenchmark(int count) {
+    if (count <= 0) {
+        return ERROR;
+    }
+    int* keys = (int*)malloc((size_t)count * sizeof(int));
+    int* queries = (int*)malloc(MAP_OPERATIONS * sizeof(int));
+    SortedIndex index = {(int*)malloc((size_t)count * sizeof(int)), (int*)malloc((size_t)count * sizeof(int)), count};
+    if (!keys || !queries || !index.keys || !index.values) {
+        free(keys);
+        free(queries);
+        free(index.keys);
+        free(index.values);
+        return ERROR;
+    }
+
+    //Even keys are shuffled, every one of them is put once
+    unsigned int seed = 12345;
+    for (int i = 0; i < count; i++) {
+        keys[i] = 2 * i;
+    }
+    for (int i = count - 1; i > 0; i--) {
+        int j = (int)((unsigned int)randomValue(&seed) % (unsigned int)(i + 1));
+        int key = keys[i];
+        keys[i] = keys[j];
+        keys[j] = key;
+    }
+    fillQueries(queries, count);
+
+    printf("structure\toperation\tkeys\tns_per_op\tcheck\n");
+    runMapCases(keys, count, queries);
+
+    double begin = getTime();
+    memcpy(index.keys, keys, (size_t)count * sizeof(int));
+    sortValues(index.keys, count);
+    for (int i = 0; i < count; i++) {
+        index.values[i] = index.keys[i] / 2;
+    }
+    printMapResult("sorted_array", "build", count, getTime() - begin, count > 0 ? count : 1, count);
+    runArrayCases(&index, NULL, queries, 0);
+
+    StaticBTree tree;
+    int result = ERROR;
+    begin = getTime();
+    if (buildStaticBTree(&tree, &index) == SUCCESS) {
+        printMapResult("static_btree", "build", count, getTime() - begin, count > 0 ? count : 1, count);
+        runArrayCases(&index, &tree, queries, 1);
+        freeStaticBTree(&tree);
+        result = SUCCESS;
+    }
+
+    free(keys);
+    free(queries);
+    free(index.keys);
+    free(index.values);
+
+    return result;
+}
+
+/////Concurrent benchmark
+//Run as "bench-mt [keys]". Readers look for random keys while one writer inserts new ones, for
+//the lock-free readers and for a tree under one mutex. Lookups and inserts are given per second
+
+#define MAX_BENCHMARK_READERS 16
+#define CONCURRENT_RUN_TIME 0.5
+
+typedef struct _counter Counter;
+typedef struct _concurrent_run ConcurrentRun;
+
+struct _counter {
+    unsigned long long count;
+    unsigned long long found;
+    char padding[CACHE_LINE - 2 * sizeof(unsigned long long)];
+};
+
+struct _concurrent_run {
+    Counter counters[MAX_BENCHMARK_READERS + 1];
+    ConcurrentTree* concurrentTree;
+    Tree* lockedTree;
+    pthread_mutex_t lock;
+    int keys;
+    int isRunning;
+    int nextReader;
+    int isFailed;
+};
+
+int lockedContains(ConcurrentRun* run, int value) {
+    pthread_mutex_lock(&run -> lock);
+    int isFound = containsValue(run -> lockedTree, value);
+    pthread_mutex_unlock(&run -> lock);
+
+    return isFound;
+}
+
+void* readerLoop(void* argument) {
+    ConcurrentRun* run = (ConcurrentRun*)argument;
+    int reader = __atomic_fetch_add(&run -> nextReader, 1, __ATOMIC_SEQ_CST);
+    int slot = run -> concurrentTree ? registerReader(run -> concurrentTree) : -1;
+    if (run -> concurrentTree && slot < 0) {
+        __atomic_store_n(&run -> isFailed, 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+    unsigned int seed = 1000 + (unsigned int)reader;
+
+    unsigned long long count = 0, found = 0;
+    while (__atomic_load_n(&run -> isRunning, __ATOMIC_RELAXED)) {
+        int value = (int)((unsigned int)randomValue(&seed) % (2 * (unsigned int)run -> keys));
+        found += run -> concurrentTree ? concurrentContains(run -> concurrentTree, slot, value) :
+                lockedContains(run, value);
+        count++;
+    }
+    run -> counters[reader].count = count;
+    run -> counters[reader].found = found;
+    if (run -> concurrentTree) {
+        unregisterReader(run -> concurrentTree, slot);
+    }
+
+    return NULL;
+}
+
+//Writer puts odd keys, the tree has even ones from the start
+void* writerLoop(void* argument) {
+    ConcurrentRun* run = (ConcurrentRun*)argument;
+    unsigned int seed = 99;
+
+    unsigned long long count = 0;
+    while (__atomic_load_n(&run -> isRunning, __ATOMIC_RELAXED)) {
+        int value = 2 * (int)((unsigned int)randomValue(&seed) % (unsigned int)run -> keys) + 1;
+        if (run -> concurrentTree) {
+            if (concurrentInsert(run -> concurrentTree, value) != SUCCESS) {
+                break;
+            }
+        } else {
+            pthread_mutex_lock(&run -> lock);
+            int result = insertValue(run -> lockedTree, value);
+            pthread_mutex_unlock(&run -> lock);
+            if (result != SUCCESS) {
+                break;
+            }
+        }
+        count++;
+    }
+    run -> counters[MAX_BENCHMARK_READERS].count = count;
+
+    return NULL;
+}
+
+int runConcurrentCase(int* values, int keys, int readerCount, int isLocked) {
+    ConcurrentRun* run = (ConcurrentRun*)_mm_malloc(sizeof(ConcurrentRun), CACHE_LINE);
+    if (!run) {
+        return ERROR;
+    }
+    memset(run, 0, sizeof(ConcurrentRun));
+
+    Tree tree = {NULL};
+    fillKeys(values, keys, SORTED_KEYS);
+    if (bulkBuild(&tree, values, keys) != SUCCESS) {
+        _mm_free(run);
+        return ERROR;
+    }
+    if (isLocked) {
+        run -> lockedTree = &tree;
+    } else if (!(run -> concurrentTree = createConcurrentTree(&tree))) {
+        freeTree(&tree);
+        _mm_free(run);
+        return ERROR;
+    }
+    pthread_mutex_init(&run -> lock, NULL);
+    run -> keys = keys;
+    run -> isRunning = 1;
+
+    pthread_t threads[MAX_BENCHMARK_READERS + 1];
+    int threadCount = 0;
+    int result = SUCCESS;
+    for (; threadCount < readerCount; threadCount++) {
+        if (pthread_create(&threads[threadCount], NULL, readerLoop, run) != 0) {
+            result = ERROR;
+            break;
+        }
+    }
+    if (result == SUCCESS) {
+        if (pthread_create(&threads[threadCount], NULL, writerLoop, run) != 0) {
+            result = ERROR;
+        } else {
+            threadCount++;
+        }
+    }
+
+    double begin = getTime();
+    if (result == SUCCESS) {
+        usleep((useconds_t)(CONCURRENT_RUN_TIME * 1e6));
+    }
+    __atomic_store_n(&run -> isRunning, 0, __ATOMIC_RELAXED);
+    for (int i = 0; i < threadCount; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    double time = getTime() - begin;
+    if (run -> isFailed) {
+        result = ERROR;
+    }
+
+    unsigned long long lookups = 0;
+    for (int i = 0; i < readerCount; i++) {
+        lookups += run -> counters[i].count;
+    }
+    if (result == SUCCESS) {
+        printf("%s\t%d\t%.0f\t%.0f\n", isLocked ? "mutex" : "copy_on_write", readerCount, lookups / time,
+                run -> counters[MAX_BENCHMARK_READERS].count / time);
+    }
+
+    if (run -> concurrentTree) {
+        freeConcurrentTree(run -> concurrentTree);
+    }
+    freeTree(&tree);
+    pthread_mutex_destroy(&run -> lock);
+    _mm_free(run);
+
+    return result;
+}
+
+int concurrentBenchmark(int keys) {
+    int* values = (int*)malloc((size_t)(keys > 0 ? keys : 1) * sizeof(int));
+    if (!values || keys <= 0) {
+        free(values);
+        return ERROR;
+    }
+
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    int maxReaders = processors > 0 && processors * 2 < MAX_BENCHMARK_READERS ? (int)processors * 2 :
+            MAX_BENCHMARK_READERS;
+
+    printf("structure\treaders\tlookups_per_s\tinserts_per_s\n");
+    int result = SUCCESS;
+    for (int isLocked = 0; isLocked < 2 && result == SUCCESS; isLocked++) {
+        for (int readers = 1; readers <= maxReaders && result == SUCCESS; readers *= 2) {
+            result = runConcurrentCase(values, keys, readers, isLocked);
+        }
+    }
+    free(values);
+
+    return result;
+}
+
+/////Index benchmark
+//Run as "bench-index [keys]". Keys in random order go one by one into the pointer tree and into
+//the B+-tree, then both answer the same random lookups, half of them for present keys. Lookup
+//time is given per operation, memory is the growth of the heap while the index is built
+
+#define LOOKUP_COUNT (1 << 22)
+
+void fillIndexQueries(int* queries, const int* values, int keys) {
+    unsigned int seed = 4242;
+    for (int i = 0; i < LOOKUP_COUNT; i++) {
+        unsigned int pick = (unsigned int)randomValue(&seed);
+        queries[i] = pick & 1 ? values[(pick >> 1) % (unsigned int)keys] : randomValue(&seed);
+    }
+}
+
+void printIndexResult(const char* name, int keys, double time, double lookupTime, int treeHeight, size_t bytes,
+        int found) {
+    printf("%s\t%d\t%.3f\t%.1f\t%d\t%zu\t%d\n", name, keys, time, lookupTime * 1e9 / LOOKUP_COUNT,
+            treeHeight, bytes, found);
+}
+
+int runAvlIndexCase(const int* values, int keys, const int* queries, int* found) {
+    Tree tree = {NULL};
+    size_t heapSize = getHeapSize();
+
+    double begin = getTime();
+    int result = SUCCESS;
+    for (int i = 0; i < keys && result == SUCCESS; i++) {
+        result = insertValue(&tree, values[i]);
+    }
+    double time = getTime() - begin;
+    size_t bytes = getHeapSize() - heapSize;
+
+    begin = getTime();
+    *found = 0;
+    for (int i = 0; i < LOOKUP_COUNT && result == SUCCESS; i++) {
+        *found += containsValue(&tree, queries[i]);
+    }
+    if (result == SUCCESS) {
+        printIndexResult("avl", keys, time, getTime() - begin, height(tree.root), bytes, *found);
+    }
+    freeTree(&tree);
+
+    return result;
+}
+
+int runBTreeIndexCase(const int* values, int keys, const int* queries, int* found) {
+    BTree tree;
+    initBTree(&tree);
+    size_t heapSize = getHeapSize();
+
+    double begin = getTime();
+    int result = SUCCESS;
+    for (int i = 0; i < keys && result == SUCCESS; i++) {
+        result = btreeInsert(&tree, values[i]);
+    }
+    double time = getTime() - begin;
+    size_t bytes = getHeapSize() - heapSize;
+
+    begin = getTime();
+    *found = 0;
+    for (int i = 0; i < LOOKUP_COUNT && result == SUCCESS; i++) {
+        *found += btreeContains(&tree, queries[i]);
+    }
+    if (result == SUCCESS) {
+        printIndexResult("bplus_tree", keys, time, getTime() - begin, btreeHeight(&tree), bytes, *found);
+    }
+    freeBTree(&tree);
+
+    return result;
+}
+
+//Both indexes have to find the same number of keys, otherwise the benchmark fails
+int indexBenchmark(int keys) {
+    if (keys <= 0) {
+        return ERROR;
+    }
+    int* values = (int*)malloc((size_t)keys * sizeof(int));
+    int* queries = (int*)malloc((size_t)LOOKUP_COUNT * sizeof(int));
+    if (!values || !queries) {
+        free(values);
+        free(queries);
+        return ERROR;
+    }
+    fillKeys(values, keys, RANDOM_KEYS);
+    fillIndexQueries(queries, values, keys);
+
+    printf("structure\tkeys\tbuild_seconds\tlookup_ns\theight\tbytes\tfound\n");
+    int avlFound;
+    int btreeFound;
+    int result = runAvlIndexCase(values, keys, queries, &avlFound);
+    if (result == SUCCESS) {
+        result = runBTreeIndexCase(values, keys, queries, &btreeFound);
+    }
+    if (result == SUCCESS && avlFound != btreeFound) {
+        result = ERROR;
+    }
+    free(values);
+    free(queries);
+
+    return result;
+}
+
+/////Input benchmark
+//Run as "bench-input [numbers]". Text of random numbers in the format of the labs is written to a
+//temporary file, which is then parsed by fscanf and by the fast reader. Sum of the numbers is
+//printed as a check, the benchmark fails if the readers disagree
+
+void printInputResult(const char* reader, int numbers, double time, size_t bytes, long long sum) {
+    printf("%s\t%d\t%.3f\t%.1f\t%lld\n", reader, numbers, time, (double)bytes / time / 1e6, sum);
+}
+
+long long scanNumbers(FILE* file, int numbers) {
+    long long sum = 0;
+    for (int i = 0; i < numbers; i++) {
+        int value;
+        if (fscanf(file, "%d", &value) != 1) {
+            return LLONG_MIN;
+        }
+        sum += value;
+    }
+
+    return sum;
+}
+
+long long readNumbers(FastInput* input, int numbers) {
+    long long sum = 0;
+    for (int i = 0; i < numbers; i++) {
+        int value;
+        if (readInt(input, &value) != 1) {
+            return LLONG_MIN;
+        }
+        sum += value;
+    }
+
+    return sum;
+}
+
+int inputBenchmark(int numbers) {
+    FILE* file = tmpfile();
+    char* block = (char*)malloc(INPUT_BUFFER_SIZE);
+    if (!file || !block) {
+        if (file) {
+            fclose(file);
+        }
+        free(block);
+        return ERROR;
+    }
+
+    //Triples "first second length" as in the edge lists of the graph labs
+    unsigned int seed = 12345;
+    for (int i = 0; i < numbers; i++) {
+        int value = i % 3 == 2 ? randomValue(&seed) : (int)(nextRandom(&seed) % 5000 + 1);
+        fprintf(file, i % 3 == 2 ? "%d\n" : "%d ", value);
+    }
+    size_t bytes = (size_t)ftell(file);
+
+    printf("reader\tnumbers\tseconds\tmb_per_s\tsum\n");
+    rewind(file);
+    double begin = getTime();
+    long long scanSum = scanNumbers(file, numbers);
+    printInputResult("fscanf", numbers, getTime() - begin, bytes, scanSum);
+
+    rewind(file);
+    FastInput input;
+    openFileInput(&input, file, block);
+    begin = getTime();
+    long long readSum = readNumbers(&input, numbers);
+    printInputResult("fast_input", numbers, getTime() - begin, bytes, readSum);
+
+    fclose(file);
+    free(block);
+
+    return scanSum == readSum && readSum != LLONG_MIN ? SUCCESS : ERROR;
+}
+
+//////////////////
+
+int main(int argc, char** argv) {
+    if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+        return benchmark(argc > 2 ? atoi(argv[2]) : BENCHMARK_KEYS);
+    }
+    if (argc > 1 && strcmp(argv[1], "bench-map") == 0) {
+        return mapBenchmark(argc > 2 ? atoi(argv[2]) : BENCHMARK_KEYS);
+    }
+    if (argc > 1 && strcmp(argv[1], "bench-mt") == 0) {
+        return concurrentBenchmark(argc > 2 ? atoi(argv[2]) : BENCHMARK_KEYS);
+    }
+    if (argc > 1 && strcmp(argv[1], "bench-index") == 0) {
+        return indexBenchmark(argc > 2 ? atoi(argv[2]) : BENCHMARK_KEYS);
+    }
+    if (argc > 1 && strcmp(argv[1], "bench-input") == 0) {
+        return inputBenchmark(argc > 2 ? atoi(argv[2]) : BENCHMARK_KEYS);
+    }
+
     return createAVL();
 }
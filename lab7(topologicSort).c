@@ -1,6 +1,10 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <mm_malloc.h>
+#include <string.h>
+
+#include "fastInput.h"
+#include "graphFile.h"
 
 /* Exceptions */
 const char* namesOfExceptions[] = {
@@ -14,7 +18,8 @@ typedef enum {
     BAD_NUMBER_VERTICES = 1,
     BAD_NUMBER_EDGES,
     BAD_INDEX_OF_VERTICE,
-    BAD_INPUT
+    BAD_INPUT,
+    GRAPH_FILE_ERROR
 } Exceptions;
 
 short flagOfException = 0;
@@ -100,7 +105,10 @@ void checkIndexes(int n, int v1, int v2) {
     }
 }
 
-void getConnectivityTable(Graph* graph, int n, int m) {
+/*  Edges are read from the text or taken from the mapped graph file when it is given,
+    vertices of the file are checked when it is opened */
+
+void getConnectivityTable(Graph* graph, int n, int m, const GraphFile* graphFile) {
     graph -> connectivityTable = (bool**)calloc((size_t)n, sizeof(bool*));
     for (int i = 0; i < n; i++) {
         graph -> connectivityTable[i] = (bool*)calloc((size_t)n, sizeof(bool));
@@ -110,9 +118,18 @@ void getConnectivityTable(Graph* graph, int n, int m) {
             graph -> connectivityTable[i][j] = false;
         }
     }
+    if (graphFile) {
+        for (int i = 0; i < n; i++) {
+            for (unsigned int j = graphFile -> offsets[i]; j < graphFile -> offsets[i + 1]; j++) {
+                graph -> connectivityTable[i][graphFile -> targets[j]] = true;
+            }
+        }
+        return;
+    }
+    FastInput* input = standardInput();
     for (int i = 0; i < m; i++) {
         int verticeFrom, verticeTo;
-        if (scanf("%d%d", &verticeFrom, &verticeTo) != 2) {
+        if (readInt(input, &verticeFrom) != 1 || readInt(input, &verticeTo) != 1) {
             printf("%s", namesOfExceptions[3]);
             flagOfException = BAD_INPUT;
             freeDynamicMemory(graph);
@@ -129,23 +146,33 @@ void getConnectivityTable(Graph* graph, int n, int m) {
     }
 }
 
-void createGraph(Graph* graph) {
-    int n = -1, m = -1;
-    if (scanf("%d", &n) == 0) {
+/*  Quantities are read from the text or taken from the graph file and checked in both cases */
+
+void getQuantities(int* n, int* m, const GraphFile* graphFile) {
+    FastInput* input = standardInput();
+    if (graphFile) {
+        *n = graphFile -> header -> vertices;
+        *m = graphFile -> header -> edges;
+    } else if (readInt(input, n) == 0) {
         printf("%s", namesOfExceptions[3]);
         flagOfException = BAD_INPUT;
         return;
     }
-    if (scanf("%d", &m) == 0) {
+    if (!graphFile && readInt(input, m) == 0) {
         printf("%s", namesOfExceptions[3]);
         flagOfException = BAD_INPUT;
         return;
     }
-    checkQuantities(n, m);
+    checkQuantities(*n, *m);
+}
+
+void createGraph(Graph* graph, const GraphFile* graphFile) {
+    int n = -1, m = -1;
+    getQuantities(&n, &m, graphFile);
     if (flagOfException == 0) {
         graph -> numberOfVertices = n;
         graph -> numberOfEdges = m;
-        getConnectivityTable(graph, n, m);
+        getConnectivityTable(graph, n, m, graphFile);
     }
 }
 
@@ -202,9 +229,54 @@ void topologicSort(Graph* graph) {
     free(colorsOfVertices);
 }
 
-int main() {
+/*  Errors found in the text of the graph get the codes they have without the file,
+    the rest of the errors of the file share GRAPH_FILE_ERROR and keep their own messages */
+
+short reportGraphFileStatus(GraphFileStatus status) {
+    switch (status) {
+        case GRAPH_FILE_SUCCESS:
+            return 0;
+        case GRAPH_FILE_BAD_INPUT:
+            printf("%s", namesOfExceptions[3]);
+            return BAD_INPUT;
+        case GRAPH_FILE_BAD_VERTEX:
+            printf("%s", namesOfExceptions[2]);
+            return BAD_INDEX_OF_VERTICE;
+        default:
+            printf("%s", graphFileMessages[status]);
+            return GRAPH_FILE_ERROR;
+    }
+}
+
+/*  "convert <file>" writes the graph from stdin to the binary file,
+    "<file>" sorts the graph from the binary file instead of stdin */
+
+int main(int argc, char** argv) {
+    if (argc > 2 && strcmp(argv[1], "convert") == 0) {
+        int n = -1, m = -1;
+        getQuantities(&n, &m, NULL);
+        if (flagOfException > 0) {
+            return flagOfException;
+        }
+        GraphFileHeader header;
+        initGraphFileHeader(&header, n, m, 0);
+        return reportGraphFileStatus(convertGraphText(standardInput(), argv[2], &header));
+    }
+    GraphFile graphFile;
+    GraphFile* source = NULL;
+    if (argc > 1) {
+        short opening = reportGraphFileStatus(openGraphFile(&graphFile, argv[1], 0));
+        if (opening > 0) {
+            return opening;
+        }
+        source = &graphFile;
+    }
+
     Graph* graph = calloc(1, sizeof(Graph));
-    createGraph(graph);
+    createGraph(graph, source);
+    if (source) {
+        closeGraphFile(source);
+    }
     if (flagOfException > 0) {
         free(graph);
         return flagOfException;
@@ -6,6 +6,10 @@
 #include <stdlib.h>
 #include <mm_malloc.h>
 #include <limits.h>
+#include <string.h>
+
+#include "fastInput.h"
+#include "graphFile.h"
 
 #define MAX_VERTICES 5000
 #define MAX_LENGTH INT_MAX
@@ -18,7 +22,8 @@ typedef enum {
     BAD_VERTEX,
     BAD_LENGTH,
     BAD_INPUT,
-    NO_SPAN_TREE
+    NO_SPAN_TREE,
+    GRAPH_FILE_ERROR
 } ExitCodes;
 
 const char* exitMessages[] = {
@@ -29,7 +34,8 @@ const char* exitMessages[] = {
         "bad vertex",
         "bad length",
         "bad number of lines",
-        "no spanning tree"
+        "no spanning tree",
+        "bad graph file"
 };
 
 typedef struct _edge Edge;
@@ -79,8 +85,13 @@ Edge* createArray(int edges) {
     return array;
 }
 
-ExitCodes getInputAndCheck(int *vertices, int *edges) {
-    if (scanf("%d%d", vertices, edges) < 2) {
+//Numbers are taken from the graph file when it is given, the checks are the same
+ExitCodes getInputAndCheck(int *vertices, int *edges, const GraphFile* graphFile) {
+    FastInput* input = standardInput();
+    if (graphFile) {
+        *vertices = graphFile -> header -> vertices;
+        *edges = graphFile -> header -> edges;
+    } else if (readInt(input, vertices) != 1 || readInt(input, edges) != 1) {
         return BAD_INPUT;
     }
 
@@ -116,11 +127,25 @@ boolean checkSpanTree(int vertices, int edges, Edge* arrayOfEdges, int* dsu) {
     return true;
 }
 
+//Edges of the graph file have checked vertices and lengths. They are put back in the order of the
+//text, so edges of equal lengths are taken in the same order as without the file
+ExitCodes fillArrayFromFile(const GraphFile* graphFile, Edge* arrayOfEdges) {
+    for (int i = 0; i < graphFile -> header -> vertices; i++) {
+        for (unsigned int j = graphFile -> offsets[i]; j < graphFile -> offsets[i + 1]; j++) {
+            arrayOfEdges[graphFile -> places[j]] = (Edge){i + 1, graphFile -> targets[j] + 1, graphFile -> weights[j]};
+        }
+    }
+
+    return SUCCESS;
+}
+
 ExitCodes fillArray(int vertices, int edges, Edge* arrayOfEdges) {
+    FastInput* input = standardInput();
     for (int i = 0; i < edges; i++) {
         int firstVertice, secondVertice;
         long long length;
-        if (scanf("%d%d%lli", &firstVertice, &secondVertice, &length) < 3) {
+        if (readInt(input, &firstVertice) != 1 || readInt(input, &secondVertice) != 1 ||
+                readLongLong(input, &length) != 1) {
             return BAD_INPUT;
         }
 
@@ -167,12 +192,12 @@ void freeMemory(Edge* arrEdges, int* dsu) {
     }
 }
 
-ExitCodes KruskalAlgorithm() {
+ExitCodes KruskalAlgorithm(const GraphFile* graphFile) {
     int vertices, edges;
     Edge* arrayOfEdges;
 
     ExitCodes getInput;
-    if ((getInput = getInputAndCheck(&vertices, &edges)) != SUCCESS) {
+    if ((getInput = getInputAndCheck(&vertices, &edges, graphFile)) != SUCCESS) {
         return getInput;
     }
 
@@ -182,7 +207,8 @@ ExitCodes KruskalAlgorithm() {
     }
 
     ExitCodes fillingArray;
-    if ((fillingArray = fillArray(vertices, edges, arrayOfEdges)) != SUCCESS) {
+    fillingArray = graphFile ? fillArrayFromFile(graphFile, arrayOfEdges) : fillArray(vertices, edges, arrayOfEdges);
+    if (fillingArray != SUCCESS) {
         freeMemory(arrayOfEdges, NULL);
         return fillingArray;
     }
@@ -216,11 +242,64 @@ ExitCodes KruskalAlgorithm() {
     return SUCCESS;
 }
 
-int main() {
+//Errors found in the text of the graph get the codes they have without the file, the rest of the
+//errors of the file share GRAPH_FILE_ERROR and keep their own messages
+ExitCodes reportGraphFileStatus(GraphFileStatus status) {
+    ExitCodes code;
+    switch (status) {
+        case GRAPH_FILE_SUCCESS:
+            return SUCCESS;
+        case GRAPH_FILE_NO_MEMORY:
+            code = OUT_OF_MEMORY;
+            break;
+        case GRAPH_FILE_BAD_INPUT:
+            code = BAD_INPUT;
+            break;
+        case GRAPH_FILE_BAD_VERTEX:
+            code = BAD_VERTEX;
+            break;
+        case GRAPH_FILE_BAD_LENGTH:
+            code = BAD_LENGTH;
+            break;
+        default:
+            printf("%s", graphFileMessages[status]);
+            return GRAPH_FILE_ERROR;
+    }
+    printf("%s", exitMessages[code]);
+
+    return code;
+}
+
+//"convert <file>" writes the graph from stdin to the binary file, "<file>" takes the graph from it
+int main(int argc, char** argv) {
+    if (argc > 2 && strcmp(argv[1], "convert") == 0) {
+        int vertices, edges;
+        ExitCodes getInput;
+        if ((getInput = getInputAndCheck(&vertices, &edges, NULL)) != SUCCESS) {
+            printf("%s", exitMessages[getInput]);
+            return getInput;
+        }
+
+        GraphFileHeader header;
+        initGraphFileHeader(&header, vertices, edges, 1);
+        return reportGraphFileStatus(convertGraphText(standardInput(), argv[2], &header));
+    }
+
+    GraphFile graphFile;
+    if (argc > 1) {
+        ExitCodes opening = reportGraphFileStatus(openGraphFile(&graphFile, argv[1], 1));
+        if (opening != SUCCESS) {
+            return opening;
+        }
+    }
+
     ExitCodes completingAlgorithm;
-    if ((completingAlgorithm = KruskalAlgorithm()) != SUCCESS) {
+    if ((completingAlgorithm = KruskalAlgorithm(argc > 1 ? &graphFile : NULL)) != SUCCESS) {
         printf("%s", exitMessages[completingAlgorithm]);
     }
+    if (argc > 1) {
+        closeGraphFile(&graphFile);
+    }
 
     return completingAlgorithm;
 }
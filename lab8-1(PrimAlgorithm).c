@@ -2,6 +2,10 @@
 #include <mm_malloc.h>
 #include <stdbool.h>
 #include <limits.h>
+#include <string.h>
+
+#include "fastInput.h"
+#include "graphFile.h"
 
 #define ll long long
 
@@ -13,7 +17,8 @@ typedef enum {
     BAD_VERTEX,
     BAD_LENGTH,
     BAD_INPUT,
-    NO_SPANNING_TREE
+    NO_SPANNING_TREE,
+    GRAPH_FILE_ERROR
 } ExitCodes;
 
 const char* exitMessages[] = {
@@ -24,7 +29,8 @@ const char* exitMessages[] = {
         "bad vertex",
         "bad length",
         "bad number of lines",
-        "no spanning tree"
+        "no spanning tree",
+        "bad graph file"
 };
 
 typedef struct _context Context;
@@ -63,9 +69,14 @@ void freeMem(Context *ctx, int** g, bool* hasEdge, ll* pQueue, int* from) {
     }
 }
 
-ExitCodes getInputAndCheck(Context* ctx) {
+//Numbers are taken from the graph file when it is given, the checks are the same
+ExitCodes getInputAndCheck(Context* ctx, const GraphFile* graphFile) {
+    FastInput* input = standardInput();
     int vertices, edges;
-    if (scanf("%d%d", &vertices, &edges) < 2) {
+    if (graphFile) {
+        vertices = graphFile -> header -> vertices;
+        edges = graphFile -> header -> edges;
+    } else if (readInt(input, &vertices) != 1 || readInt(input, &edges) != 1) {
         return BAD_INPUT;
     }
 
@@ -83,11 +94,28 @@ ExitCodes getInputAndCheck(Context* ctx) {
     return SUCCESS;
 }
 
+//Edges of the graph file have checked vertices and lengths
+ExitCodes fillGraphFromFile(Context* ctx, const GraphFile* graphFile, int** g, bool* hasEdge) {
+    for (int i = 0; i < ctx -> vertices; i++) {
+        for (unsigned int j = graphFile -> offsets[i]; j < graphFile -> offsets[i + 1]; j++) {
+            int second = graphFile -> targets[j];
+            int length = graphFile -> weights[j];
+            g[i][second] = length;
+            g[second][i] = length;
+            hasEdge[i] = true;
+            hasEdge[second] = true;
+        }
+    }
+
+    return SUCCESS;
+}
+
 ExitCodes fillGraph(Context* ctx, int** g, bool* hasEdge) {
+    FastInput* input = standardInput();
     for (int i = 0; i < ctx -> edges; i++) {
         int first, second;
         ll length;
-        if (scanf("%d%d%lli", &first, &second, &length) < 3) {
+        if (readInt(input, &first) != 1 || readInt(input, &second) != 1 || readLongLong(input, &length) != 1) {
             return BAD_INPUT;
         }
 
@@ -166,7 +194,7 @@ ExitCodes PrimAlgo(Context* ctx, int** g, bool* hasEdge) {
     return SUCCESS;
 }
 
-ExitCodes start() {
+ExitCodes start(const GraphFile* graphFile) {
     Context* ctx = (Context*)calloc(1, sizeof(Context));
     if (!ctx) {
         return OUT_OF_MEMORY;
@@ -174,7 +202,7 @@ ExitCodes start() {
 
     ExitCodes currentAction;
 
-    if ((currentAction = getInputAndCheck(ctx)) != SUCCESS) {
+    if ((currentAction = getInputAndCheck(ctx, graphFile)) != SUCCESS) {
         freeMem(ctx, NULL, NULL, NULL, NULL);
         return currentAction;
     }
@@ -199,7 +227,8 @@ ExitCodes start() {
     }
 
 
-    if ((currentAction = fillGraph(ctx, g, hasEdge)) != SUCCESS) {
+    currentAction = graphFile ? fillGraphFromFile(ctx, graphFile, g, hasEdge) : fillGraph(ctx, g, hasEdge);
+    if (currentAction != SUCCESS) {
         freeMem(ctx, g, hasEdge, NULL, NULL);
         return currentAction;
     }
@@ -211,11 +240,64 @@ ExitCodes start() {
     return SUCCESS;
 }
 
-int main() {
+//Errors found in the text of the graph get the codes they have without the file, the rest of the
+//errors of the file share GRAPH_FILE_ERROR and keep their own messages
+ExitCodes reportGraphFileStatus(GraphFileStatus status) {
+    ExitCodes code;
+    switch (status) {
+        case GRAPH_FILE_SUCCESS:
+            return SUCCESS;
+        case GRAPH_FILE_NO_MEMORY:
+            code = OUT_OF_MEMORY;
+            break;
+        case GRAPH_FILE_BAD_INPUT:
+            code = BAD_INPUT;
+            break;
+        case GRAPH_FILE_BAD_VERTEX:
+            code = BAD_VERTEX;
+            break;
+        case GRAPH_FILE_BAD_LENGTH:
+            code = BAD_LENGTH;
+            break;
+        default:
+            printf("%s", graphFileMessages[status]);
+            return GRAPH_FILE_ERROR;
+    }
+    printf("%s", exitMessages[code]);
+
+    return code;
+}
+
+//"convert <file>" writes the graph from stdin to the binary file, "<file>" takes the graph from it
+int main(int argc, char** argv) {
+    if (argc > 2 && strcmp(argv[1], "convert") == 0) {
+        Context ctx;
+        ExitCodes getInput;
+        if ((getInput = getInputAndCheck(&ctx, NULL)) != SUCCESS) {
+            printf("%s", exitMessages[getInput]);
+            return getInput;
+        }
+
+        GraphFileHeader header;
+        initGraphFileHeader(&header, ctx.vertices, ctx.edges, 1);
+        return reportGraphFileStatus(convertGraphText(standardInput(), argv[2], &header));
+    }
+
+    GraphFile graphFile;
+    if (argc > 1) {
+        ExitCodes opening = reportGraphFileStatus(openGraphFile(&graphFile, argv[1], 1));
+        if (opening != SUCCESS) {
+            return opening;
+        }
+    }
+
     ExitCodes exec;
-    if ((exec = start()) != SUCCESS) {
+    if ((exec = start(argc > 1 ? &graphFile : NULL)) != SUCCESS) {
         printf("%s", exitMessages[exec]);
     }
+    if (argc > 1) {
+        closeGraphFile(&graphFile);
+    }
 
     return exec;
 }
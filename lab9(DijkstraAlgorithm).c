@@ -2,6 +2,11 @@
 #include <mm_malloc.h>
 #include <stdbool.h>
 #include <limits.h>
+#include <string.h>
+#include <errno.h>
+
+#include "fastInput.h"
+#include "graphFile.h"
 
 #define ll long long
 
@@ -13,6 +18,7 @@ typedef enum {
     BAD_VERTEX,
     BAD_LENGTH,
     BAD_INPUT,
+    GRAPH_FILE_ERROR,
 } ExitCodes;
 
 const char* exitMessages[] = {
@@ -23,6 +29,7 @@ const char* exitMessages[] = {
         "bad vertex",
         "bad length",
         "bad number of lines",
+        "bad graph file",
 };
 
 typedef struct _context Context;
@@ -63,9 +70,36 @@ void freeMem(Context *ctx, int** g, ll* distances, int* parents, bool* used) {
     }
 }
 
-ExitCodes getInputAndCheck(Context* ctx) {
+//Vertex of the query is a whole number, one out of int is left to the check of vertices as 0
+ExitCodes parseQueryVertex(const char* text, int* vertex) {
+    char* end;
+    errno = 0;
+    long value = strtol(text, &end, 10);
+    if (end == text || *end != '\0') {
+        return BAD_INPUT;
+    }
+
+    *vertex = errno == ERANGE || value < INT_MIN || value > INT_MAX ? 0 : (int)value;
+
+    return SUCCESS;
+}
+
+//Numbers are taken from the graph file when it is given, the query may replace its start and destination.
+//The checks are the same
+ExitCodes getInputAndCheck(Context* ctx, const GraphFile* graphFile, char** query) {
+    FastInput* input = standardInput();
     int vertices, edges, start, destination;
-    if (scanf("%d%d%d%d", &vertices, &start, &destination, &edges) < 4) {
+    if (graphFile) {
+        vertices = graphFile -> header -> vertices;
+        edges = graphFile -> header -> edges;
+        start = graphFile -> header -> start;
+        destination = graphFile -> header -> destination;
+        if (query && (parseQueryVertex(query[0], &start) != SUCCESS ||
+                parseQueryVertex(query[1], &destination) != SUCCESS)) {
+            return BAD_INPUT;
+        }
+    } else if (readInt(input, &vertices) != 1 || readInt(input, &start) != 1 || readInt(input, &destination) != 1 ||
+            readInt(input, &edges) != 1) {
         return BAD_INPUT;
     }
 
@@ -89,11 +123,26 @@ ExitCodes getInputAndCheck(Context* ctx) {
     return SUCCESS;
 }
 
+//Edges of the graph file have checked vertices and lengths
+ExitCodes fillGraphFromFile(Context* ctx, const GraphFile* graphFile, int** g) {
+    for (int i = 0; i < ctx -> vertices; i++) {
+        for (unsigned int j = graphFile -> offsets[i]; j < graphFile -> offsets[i + 1]; j++) {
+            int second = graphFile -> targets[j];
+            int length = graphFile -> weights[j];
+            g[i][second] = length;
+            g[second][i] = length;
+        }
+    }
+
+    return SUCCESS;
+}
+
 ExitCodes fillGraph(Context* ctx, int** g) {
+    FastInput* input = standardInput();
     for (int i = 0; i < ctx -> edges; i++) {
         int first, second;
         ll length;
-        if (scanf("%d%d%lli", &first, &second, &length) < 3) {
+        if (readInt(input, &first) != 1 || readInt(input, &second) != 1 || readLongLong(input, &length) != 1) {
             return BAD_INPUT;
         }
 
@@ -207,7 +256,7 @@ ExitCodes DijkstraAlgo(Context* ctx, int** g) {
     return SUCCESS;
 }
 
-ExitCodes start() {
+ExitCodes start(const GraphFile* graphFile, char** query) {
     Context* ctx = (Context*)calloc(1, sizeof(Context));
     if (!ctx) {
         return OUT_OF_MEMORY;
@@ -215,7 +264,7 @@ ExitCodes start() {
 
     ExitCodes currentAction;
 
-    if ((currentAction = getInputAndCheck(ctx)) != SUCCESS) {
+    if ((currentAction = getInputAndCheck(ctx, graphFile, query)) != SUCCESS) {
         freeMem(ctx, NULL, NULL, NULL, NULL);
         return currentAction;
     }
@@ -233,7 +282,8 @@ ExitCodes start() {
         }
     }
 
-    if ((currentAction = fillGraph(ctx, g)) != SUCCESS) {
+    currentAction = graphFile ? fillGraphFromFile(ctx, graphFile, g) : fillGraph(ctx, g);
+    if (currentAction != SUCCESS) {
         freeMem(ctx, g, NULL, NULL, NULL);
         return currentAction;
     }
@@ -245,11 +295,72 @@ ExitCodes start() {
     return SUCCESS;
 }
 
-int main() {
+//Errors found in the text of the graph get the codes they have without the file, the rest of the
+//errors of the file share GRAPH_FILE_ERROR and keep their own messages
+ExitCodes reportGraphFileStatus(GraphFileStatus status) {
+    ExitCodes code;
+    switch (status) {
+        case GRAPH_FILE_SUCCESS:
+            return SUCCESS;
+        case GRAPH_FILE_NO_MEMORY:
+            code = OUT_OF_MEMORY;
+            break;
+        case GRAPH_FILE_BAD_INPUT:
+            code = BAD_INPUT;
+            break;
+        case GRAPH_FILE_BAD_VERTEX:
+            code = BAD_VERTEX;
+            break;
+        case GRAPH_FILE_BAD_LENGTH:
+            code = BAD_LENGTH;
+            break;
+        default:
+            printf("%s", graphFileMessages[status]);
+            return GRAPH_FILE_ERROR;
+    }
+    printf("%s", exitMessages[code]);
+
+    return code;
+}
+
+//"convert <file>" writes the graph from stdin to the binary file, "<file> [start destination]" takes
+//the graph from it, so several queries on one graph don't parse it again
+int main(int argc, char** argv) {
+    if (argc > 2 && strcmp(argv[1], "convert") == 0) {
+        Context ctx;
+        ExitCodes getInput;
+        if ((getInput = getInputAndCheck(&ctx, NULL, NULL)) != SUCCESS) {
+            printf("%s", exitMessages[getInput]);
+            return getInput;
+        }
+
+        GraphFileHeader header;
+        initGraphFileHeader(&header, ctx.vertices, ctx.edges, 1);
+        header.start = ctx.start;
+        header.destination = ctx.destination;
+        return reportGraphFileStatus(convertGraphText(standardInput(), argv[2], &header));
+    }
+
+    if (argc == 3 || argc > 4) {
+        printf("usage: %s [convert <file> | <file> [start destination]]", argv[0]);
+        return BAD_INPUT;
+    }
+
+    GraphFile graphFile;
+    if (argc > 1) {
+        ExitCodes opening = reportGraphFileStatus(openGraphFile(&graphFile, argv[1], 1));
+        if (opening != SUCCESS) {
+            return opening;
+        }
+    }
+
     ExitCodes exec;
-    if ((exec = start()) != SUCCESS) {
+    if ((exec = start(argc > 1 ? &graphFile : NULL, argc == 4 ? argv + 2 : NULL)) != SUCCESS) {
         printf("%s", exitMessages[exec]);
     }
+    if (argc > 1) {
+        closeGraphFile(&graphFile);
+    }
 
     return exec;
 }